@@ -0,0 +1,1261 @@
+/*
+ * jstok micro-benchmarks
+ *
+ *   bench_jstok_<config> [scenario...]
+ *
+ * Every scenario parses a generated document in a loop for a fixed time
+ * budget and reports input throughput. Build with optimizations
+ * (meson setup -Dbuildtype=release) for meaningful numbers.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jstok.h"
+
+#ifndef JSTOK_BENCH_CONFIG
+#define JSTOK_BENCH_CONFIG "default"
+#endif
+
+#define BENCH_MIN_SECONDS 0.25
+
+static char bench_config[32] = JSTOK_BENCH_CONFIG;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct bench_buf {
+    char* p;
+    size_t n;
+    size_t cap;
+} bench_buf;
+
+static void buf_put(bench_buf* b, const char* s, size_t n) {
+    if (b->n + n + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 4096;
+        while (b->n + n + 1 > cap) cap *= 2;
+        b->p = (char*)realloc(b->p, cap);
+        if (!b->p) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        b->cap = cap;
+    }
+    memcpy(b->p + b->n, s, n);
+    b->n += n;
+    b->p[b->n] = '\0';
+}
+
+static void buf_puts(bench_buf* b, const char* s) {
+    buf_put(b, s, strlen(s));
+}
+
+/* Parse json repeatedly, print MB/s and return the token count */
+static int bench_parse(const char* label, const char* json, size_t len, jstoktok_t* toks, int max_tokens) {
+    jstok_parser p;
+    double t0, t1;
+    long iters = 0;
+    int r = 0;
+
+    t0 = now_sec();
+    do {
+        jstok_init(&p);
+        r = jstok_parse(&p, json, (int)len, toks, max_tokens);
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+
+    if (r < 0) {
+        fprintf(stderr, "%s: parse failed (%d at %d)\n", label, r, p.error_pos);
+        exit(1);
+    }
+
+    printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, label, len, r, (double)len * (double)iters / (t1 - t0) / 1e9);
+    return r;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Scenarios */
+/* -------------------------------------------------------------------------- */
+
+/* Arrays of string values, 8 B to 1 MB each, ~4 MB of input per document */
+static void scenario_strings(void) {
+    static const size_t sizes[] = {8, 64, 512, 4096, 65536, 1048576};
+    size_t s;
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        bench_buf b = {0};
+        char* body = (char*)malloc(sizes[s]);
+        jstoktok_t* toks;
+        char label[64];
+        size_t i, count = (4u << 20) / (sizes[s] + 3) + 1;
+
+        for (i = 0; i < sizes[s]; i++) body[i] = (char)('a' + (i * 7) % 26);
+
+        buf_puts(&b, "[");
+        for (i = 0; i < count; i++) {
+            if (i) buf_puts(&b, ",");
+            buf_puts(&b, "\"");
+            buf_put(&b, body, sizes[s]);
+            buf_puts(&b, "\"");
+        }
+        buf_puts(&b, "]");
+
+        toks = (jstoktok_t*)malloc((count + 1) * sizeof(*toks));
+        snprintf(label, sizeof(label), "strings/%zu", sizes[s]);
+        bench_parse(label, b.p, b.n, toks, (int)count + 1);
+
+        free(toks);
+        free(body);
+        free(b.p);
+    }
+}
+
+/* Newline plus indentation for depth, nothing when minified */
+static void corpus_nl(bench_buf* b, int indent, int depth) {
+    static const char spaces[] = "                                                                ";
+    int n = indent * depth;
+
+    if (indent == 0) return;
+    buf_puts(b, "\n");
+    while (n > 0) {
+        int k = n < (int)sizeof(spaces) - 1 ? n : (int)sizeof(spaces) - 1;
+        buf_put(b, spaces, (size_t)k);
+        n -= k;
+    }
+}
+
+/* API-style records; indent 0 gives the minified form of the same document */
+static void corpus_records(bench_buf* b, int records, int indent) {
+    const char* colon = indent ? ": " : ":";
+    char tmp[256];
+    int i;
+
+    buf_puts(b, "[");
+    for (i = 0; i < records; i++) {
+        if (i) buf_puts(b, ",");
+        corpus_nl(b, indent, 1);
+        buf_puts(b, "{");
+        corpus_nl(b, indent, 2);
+        snprintf(tmp, sizeof(tmp), "\"id\"%s%d,", colon, 100000 + i);
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 2);
+        snprintf(tmp, sizeof(tmp), "\"name\"%s\"user-%d\",", colon, i);
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 2);
+        snprintf(tmp, sizeof(tmp), "\"active\"%s%s,", colon, (i & 1) ? "true" : "false");
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 2);
+        snprintf(tmp, sizeof(tmp), "\"score\"%s%d.%02d,", colon, i % 100, i % 97);
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 2);
+        snprintf(tmp, sizeof(tmp), "\"tags\"%s[", colon);
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 3);
+        buf_puts(b, "\"alpha\",");
+        corpus_nl(b, indent, 3);
+        buf_puts(b, "\"beta\"");
+        corpus_nl(b, indent, 2);
+        buf_puts(b, "],");
+        corpus_nl(b, indent, 2);
+        snprintf(tmp, sizeof(tmp), "\"address\"%s{", colon);
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 3);
+        snprintf(tmp, sizeof(tmp), "\"city\"%s\"Springfield\",", colon);
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 3);
+        snprintf(tmp, sizeof(tmp), "\"zip\"%s\"%05d\"", colon, i % 100000);
+        buf_puts(b, tmp);
+        corpus_nl(b, indent, 2);
+        buf_puts(b, "}");
+        corpus_nl(b, indent, 1);
+        buf_puts(b, "}");
+    }
+    corpus_nl(b, indent, 0);
+    buf_puts(b, "]");
+}
+
+/* Same records minified and pretty-printed with growing indentation */
+static void scenario_indent(void) {
+    static const int indents[] = {0, 2, 4, 8, 16};
+    size_t i;
+
+    for (i = 0; i < sizeof(indents) / sizeof(indents[0]); i++) {
+        bench_buf b = {0};
+        jstoktok_t* toks;
+        char label[64];
+        size_t ws = 0, k;
+        int max_tokens = 5000 * 20 + 1;
+
+        corpus_records(&b, 5000, indents[i]);
+        for (k = 0; k < b.n; k++) ws += (b.p[k] == ' ' || b.p[k] == '\n');
+
+        toks = (jstoktok_t*)malloc((size_t)max_tokens * sizeof(*toks));
+        snprintf(label, sizeof(label), "indent/%d (%zu%% ws)", indents[i], ws * 100 / b.n);
+        bench_parse(label, b.p, b.n, toks, max_tokens);
+
+        free(toks);
+        free(b.p);
+    }
+}
+
+/* Flat arrays of one scalar kind: long integers, decimals, literals, 2M single digits */
+static void scenario_scalars(void) {
+    static const char* const kinds[] = {"int", "float", "literal", "digit"};
+    static const char* const lits[] = {"true", "false", "null"};
+    size_t k;
+
+    for (k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        bench_buf b = {0};
+        jstoktok_t* toks;
+        char label[64], tmp[64];
+        int i, count = k == 3 ? 2000000 : 200000;
+
+        buf_puts(&b, "[");
+        for (i = 0; i < count; i++) {
+            if (k == 0) {
+                snprintf(tmp, sizeof(tmp), "%s%lld", i ? "," : "", 1000000000000LL + (long long)i * 7919);
+            } else if (k == 1) {
+                snprintf(tmp, sizeof(tmp), "%s-%d.%06de-%d", i ? "," : "", i % 1000, (i * 7919) % 1000000, i % 30);
+            } else if (k == 2) {
+                snprintf(tmp, sizeof(tmp), "%s%s", i ? "," : "", lits[i % 3]);
+            } else {
+                snprintf(tmp, sizeof(tmp), "%s%d", i ? "," : "", i % 10);
+            }
+            buf_puts(&b, tmp);
+        }
+        buf_puts(&b, "]");
+
+        toks = (jstoktok_t*)malloc(((size_t)count + 1) * sizeof(*toks));
+        snprintf(label, sizeof(label), "scalars/%s", kinds[k]);
+        bench_parse(label, b.p, b.n, toks, count + 1);
+
+        free(toks);
+        free(b.p);
+    }
+}
+
+/* Irregular nesting and value kinds from a fixed-seed LCG, defeats branch history */
+static unsigned bench_rand_state = 12345u;
+
+static unsigned bench_rand(void) {
+    bench_rand_state = bench_rand_state * 1103515245u + 12345u;
+    return (bench_rand_state >> 16) & 0x7FFFu;
+}
+
+/* Byte length of every element of array arr, summed: one token each, or a whole primitive run at once */
+static long bench_vector_bytes(const char* json, const jstoktok_t* toks, int count, int arr) {
+    long sum = 0;
+    int i = arr + 1, k;
+
+    (void)json; /* runs only */
+    for (k = 0; k < JSTOK_TOK_SIZE(&toks[arr]) && i < count; i = jstok_skip(toks, count, i)) {
+#ifdef JSTOK_PRIMITIVE_RUNS
+        if (toks[i].type == JSTOK_PRIMITIVE_RUN) {
+            jstok_off_t pos = toks[i].start;
+            jstoktok_t e;
+
+            while (jstok_run_next(json, &toks[i], &pos, &e)) sum += e.end - e.start;
+            k += toks[i].size;
+            continue;
+        }
+#endif
+        sum += JSTOK_TOK_END(&toks[i]) - JSTOK_TOK_START(&toks[i]);
+        k++;
+    }
+    return sum;
+}
+
+/*
+ * Embedding records, 384 floats each: the parse, a pass over every element
+ * and random single elements. Under JSTOK_PRIMITIVE_RUNS each vector is one
+ * run token, read lazily.
+ */
+static void scenario_vectors(void) {
+    enum { NRECORDS = 1000, DIMS = 384, NLOOKUPS = 4096 };
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_parser p;
+    double t0, t1;
+    long elems = 0, sum = 0;
+    int *rec, *dim, *arr, count, i, j, k = 0;
+    char tmp[64];
+
+    buf_puts(&b, "[");
+    for (i = 0; i < NRECORDS; i++) {
+        snprintf(tmp, sizeof(tmp), "%s{\"id\": %d, \"embedding\": [", i ? ", " : "", i);
+        buf_puts(&b, tmp);
+        for (j = 0; j < DIMS; j++) {
+            unsigned r = bench_rand();
+            snprintf(tmp, sizeof(tmp), "%s%s0.%06u", j ? ", " : "", (r & 1) ? "-" : "", r * 31u % 1000000u);
+            buf_puts(&b, tmp);
+        }
+        buf_puts(&b, "]}");
+    }
+    buf_puts(&b, "]");
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    bench_parse("vectors/parse", b.p, b.n, toks, count);
+
+    arr = (int*)malloc(NRECORDS * sizeof(*arr));
+    for (i = 0; i < NRECORDS; i++) arr[i] = jstok_object_get(b.p, toks, count, jstok_array_at(toks, count, 0, i), "embedding");
+
+    t0 = now_sec();
+    do {
+        /* a different record each time, or the compiler hoists the pass out of the loop */
+        sum += bench_vector_bytes(b.p, toks, count, arr[k]);
+        k = k + 1 < NRECORDS ? k + 1 : 0;
+        elems += DIMS;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Melem/s\n", bench_config, "vectors/scan", (size_t)count * sizeof(*toks),
+           count, (double)elems / (t1 - t0) / 1e6);
+
+    rec = (int*)malloc(NLOOKUPS * sizeof(*rec));
+    dim = (int*)malloc(NLOOKUPS * sizeof(*dim));
+    for (i = 0; i < NLOOKUPS; i++) {
+        rec[i] = (int)(bench_rand() % NRECORDS);
+        dim[i] = (int)(bench_rand() % DIMS);
+    }
+    elems = 0;
+    k = 0;
+    t0 = now_sec();
+    do {
+        jstoktok_t e;
+#ifdef JSTOK_PRIMITIVE_RUNS
+        jstok_array_elem(b.p, toks, count, arr[rec[k]], dim[k], &e);
+#else
+        e = toks[jstok_array_at(toks, count, arr[rec[k]], dim[k])];
+#endif
+        sum += JSTOK_TOK_END(&e) - JSTOK_TOK_START(&e);
+        k = k + 1 < NLOOKUPS ? k + 1 : 0;
+        elems++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    if (sum <= 0) {
+        fprintf(stderr, "vectors: no elements\n");
+        exit(1);
+    }
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Mlookup/s\n", bench_config, "vectors/elem", b.n, count,
+           (double)elems / (t1 - t0) / 1e6);
+
+    free(dim);
+    free(rec);
+    free(arr);
+    free(toks);
+    free(b.p);
+}
+
+static void corpus_mixed_value(bench_buf* b, int depth) {
+    char tmp[64];
+    unsigned k = bench_rand() % (depth < 6 ? 8u : 5u);
+    unsigned n, i;
+
+    switch (k) {
+        case 0:
+            snprintf(tmp, sizeof(tmp), "%u", bench_rand());
+            buf_puts(b, tmp);
+            break;
+        case 1:
+            snprintf(tmp, sizeof(tmp), "-%u.%ue%u", bench_rand() % 100, bench_rand(), bench_rand() % 20);
+            buf_puts(b, tmp);
+            break;
+        case 2:
+            buf_puts(b, (bench_rand() & 1) ? "true" : "null");
+            break;
+        case 3:
+        case 4:
+            snprintf(tmp, sizeof(tmp), "\"s%.*s\"", (int)(bench_rand() % 12), "abcdefghijkl");
+            buf_puts(b, tmp);
+            break;
+        case 5:
+        case 6:
+            n = bench_rand() % 5;
+            buf_puts(b, "{");
+            for (i = 0; i < n; i++) {
+                snprintf(tmp, sizeof(tmp), "%s\"k%u\":", i ? "," : "", bench_rand() % 100);
+                buf_puts(b, tmp);
+                corpus_mixed_value(b, depth + 1);
+            }
+            buf_puts(b, "}");
+            break;
+        default:
+            n = bench_rand() % 5;
+            buf_puts(b, "[");
+            for (i = 0; i < n; i++) {
+                if (i) buf_puts(b, ",");
+                corpus_mixed_value(b, depth + 1);
+            }
+            buf_puts(b, "]");
+            break;
+    }
+}
+
+static void scenario_mixed(void) {
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_parser p;
+    int count;
+
+    buf_puts(&b, "[");
+    while (b.n < (2u << 20)) {
+        if (b.n > 1) buf_puts(&b, ",");
+        corpus_mixed_value(&b, 0);
+    }
+    buf_puts(&b, "]");
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    bench_parse("mixed", b.p, b.n, toks, count);
+
+    free(toks);
+    free(b.p);
+}
+
+/* Small flat records, 12 tokens each */
+static void corpus_dense(bench_buf* b, int records) {
+    int i;
+
+    buf_puts(b, "[");
+    for (i = 0; i < records; i++) {
+        char rec[160];
+        snprintf(rec, sizeof(rec), "%s{\"id\":%d,\"name\":\"n%u\",\"tags\":[%u,%u,%u],\"score\":%u.5,\"active\":%s}",
+                 i ? "," : "", i, bench_rand(), bench_rand() % 10, bench_rand() % 10, bench_rand() % 10, bench_rand() % 100,
+                 (bench_rand() & 1) ? "true" : "false");
+        buf_puts(b, rec);
+    }
+    buf_puts(b, "]");
+}
+
+/*
+ * Token-dense records, ~16 MB of tokens in the default layout. Reports parse
+ * throughput, the token array size, a helper pass that visits every
+ * record with jstok_skip and looks up its last key with jstok_object_get,
+ * and jstok_build_parents over the whole array.
+ */
+static void scenario_tokens(void) {
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_off_t* parent;
+    jstok_parser p;
+    double t0, t1;
+    long iters = 0, found = 0;
+    int count, i, v;
+
+    corpus_dense(&b, 80000);
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    bench_parse("tokens/parse", b.p, b.n, toks, count);
+
+    t0 = now_sec();
+    do {
+        for (i = 1; i < count; i = jstok_skip(toks, count, i)) {
+            v = jstok_object_get(b.p, toks, count, i, "active");
+            found += v >= 0;
+        }
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Mrec/s\n", bench_config, "tokens/lookup", (size_t)count * sizeof(*toks),
+           count, (double)found / (t1 - t0) / 1e6);
+
+    /* Parents on demand, against tokens/parse of a JSTOK_PARENT_LINKS build */
+    parent = (jstok_off_t*)malloc((size_t)count * sizeof(*parent));
+    iters = 0;
+    t0 = now_sec();
+    do {
+        if (jstok_build_parents(toks, count, parent) != 0) {
+            fprintf(stderr, "tokens/parents failed\n");
+            exit(1);
+        }
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+
+    printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, "tokens/parents", (size_t)count * sizeof(*parent),
+           count, (double)b.n * (double)iters / (t1 - t0) / 1e9);
+    free(parent);
+    free(toks);
+    free(b.p);
+}
+
+/*
+ * Keyed lookups in one object whose 64 values are large subtrees. Each miss
+ * skips a whole subtree, which JSTOK_SKIP_LINKS turns into one load.
+ */
+static void scenario_wide(void) {
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_parser p;
+    double t0, t1;
+    long found = 0;
+    int count, i, k;
+    char key[16];
+
+    buf_puts(&b, "{");
+    for (k = 0; k < 64; k++) {
+        snprintf(key, sizeof(key), "%s\"k%d\":", k ? "," : "", k);
+        buf_puts(&b, key);
+        corpus_dense(&b, 200);
+    }
+    buf_puts(&b, "}");
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    bench_parse("wide/parse", b.p, b.n, toks, count);
+
+    t0 = now_sec();
+    do {
+        for (k = 0; k < 64; k++) {
+            snprintf(key, sizeof(key), "k%d", k);
+            i = jstok_object_get(b.p, toks, count, 0, key);
+            found += i >= 0;
+        }
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Mlookup/s\n", bench_config, "wide/lookup", b.n, count,
+           (double)found / (t1 - t0) / 1e6);
+    free(toks);
+    free(b.p);
+}
+
+/* Element lookups by the order in idx[], through jstok_array_at or an index */
+static void bench_array_lookups(const char* label, size_t bytes, const jstoktok_t* toks, int count,
+                                const jstok_off_t* index, const int* idx, int n) {
+    double t0, t1;
+    long lookups = 0, sum = 0;
+    int batch = index ? 4096 : 1; /* one jstok_array_at call is already long */
+    int j, k = 0;
+
+    t0 = now_sec();
+    do {
+        for (j = 0; j < batch; j++) {
+            sum += index ? jstok_array_index_at(index, n, idx[k]) : jstok_array_at(toks, count, 0, idx[k]);
+            k = k + 1 < n ? k + 1 : 0;
+        }
+        lookups += batch;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    if (sum <= 0) {
+        fprintf(stderr, "%s: no elements\n", label);
+        exit(1);
+    }
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Mlookup/s\n", bench_config, label, bytes, count,
+           (double)lookups / (t1 - t0) / 1e6);
+}
+
+/*
+ * Random access into a 100k-element array: jstok_array_at walks from the
+ * first element each call, jstok_array_index is built once and then read.
+ */
+static void scenario_array(void) {
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_off_t* index;
+    jstok_parser p;
+    double t0, t1;
+    long builds = 0;
+    int *seq, *rnd, count, n, i;
+
+    corpus_dense(&b, 100000);
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    if (count <= 0) {
+        fprintf(stderr, "array: parse failed (%d)\n", count);
+        exit(1);
+    }
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    jstok_init(&p);
+    jstok_parse(&p, b.p, (int)b.n, toks, count);
+
+    n = JSTOK_TOK_SIZE(&toks[0]);
+    index = (jstok_off_t*)malloc((size_t)n * sizeof(*index));
+    seq = (int*)malloc((size_t)n * sizeof(*seq));
+    rnd = (int*)malloc((size_t)n * sizeof(*rnd));
+    for (i = 0; i < n; i++) {
+        seq[i] = i;
+        rnd[i] = (int)(((unsigned)bench_rand() << 15 | bench_rand()) % (unsigned)n);
+    }
+
+    t0 = now_sec();
+    do {
+        if (jstok_array_index(toks, count, 0, index, n) != n) {
+            fprintf(stderr, "array: index failed\n");
+            exit(1);
+        }
+        builds++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    for (i = 0; i < n; i += 997) {
+        if (jstok_array_index_at(index, n, i) != jstok_array_at(toks, count, 0, i)) {
+            fprintf(stderr, "array: index mismatch at %d\n", i);
+            exit(1);
+        }
+    }
+    printf("%-12s %-28s %10zu B %8d tok %9.3f ms\n", bench_config, "array/index/build", (size_t)n * sizeof(*index),
+           count, (t1 - t0) * 1e3 / (double)builds);
+
+    bench_array_lookups("array/at/seq", b.n, toks, count, NULL, seq, n);
+    bench_array_lookups("array/at/random", b.n, toks, count, NULL, rnd, n);
+    bench_array_lookups("array/index/seq", b.n, toks, count, index, seq, n);
+    bench_array_lookups("array/index/random", b.n, toks, count, index, rnd, n);
+
+    free(rnd);
+    free(seq);
+    free(index);
+    free(toks);
+    free(b.p);
+}
+
+/*
+ * Repeated keyed lookups in one 500-key object of small values:
+ * jstok_object_get scans the pairs each call, jstok_object_index hashes once.
+ */
+static void scenario_object(void) {
+    enum { NKEYS = 500, NSLOTS = 1024, NLOOKUPS = 4096 };
+    static char keys[NKEYS][16];
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_object_index_t ix;
+    jstok_off_t slots[NSLOTS];
+    jstok_parser p;
+    double t0, t1;
+    long builds = 0, lookups, sum;
+    int order[NLOOKUPS];
+    int count, i, j, k;
+    char item[48];
+
+    buf_puts(&b, "{");
+    for (k = 0; k < NKEYS; k++) {
+        snprintf(keys[k], sizeof(keys[k]), "field_%d", k);
+        if (k % 4)
+            snprintf(item, sizeof(item), "%s\"field_%d\":%d", k ? "," : "", k, k * 7);
+        else
+            snprintf(item, sizeof(item), "%s\"field_%d\":[1,2,{\"x\":3}]", k ? "," : "", k);
+        buf_puts(&b, item);
+    }
+    buf_puts(&b, "}");
+    for (j = 0; j < NLOOKUPS; j++) order[j] = (int)(((unsigned)bench_rand() << 15 | bench_rand()) % NKEYS);
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    if (count <= 0) {
+        fprintf(stderr, "object: parse failed (%d)\n", count);
+        exit(1);
+    }
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    jstok_init(&p);
+    jstok_parse(&p, b.p, (int)b.n, toks, count);
+
+    t0 = now_sec();
+    do {
+        if (jstok_object_index(&ix, b.p, toks, count, 0, slots, NSLOTS, (unsigned long long)builds) != 0) {
+            fprintf(stderr, "object: index failed\n");
+            exit(1);
+        }
+        builds++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    for (k = 0; k < NKEYS; k++) {
+        if (jstok_object_index_get(&ix, keys[k], strlen(keys[k])) != jstok_object_get(b.p, toks, count, 0, keys[k])) {
+            fprintf(stderr, "object: index mismatch at %s\n", keys[k]);
+            exit(1);
+        }
+    }
+    printf("%-12s %-28s %10zu B %8d tok %9.3f us\n", bench_config, "object/index/build", sizeof(slots), count,
+           (t1 - t0) * 1e6 / (double)builds);
+
+    for (i = 0; i < 2; i++) {
+        lookups = sum = 0;
+        t0 = now_sec();
+        do {
+            for (j = 0; j < NLOOKUPS; j++) {
+                const char* key = keys[order[j]];
+                sum += i ? jstok_object_index_get(&ix, key, strlen(key)) : jstok_object_get(b.p, toks, count, 0, key);
+            }
+            lookups += NLOOKUPS;
+            t1 = now_sec();
+        } while (t1 - t0 < BENCH_MIN_SECONDS);
+        if (sum <= 0) {
+            fprintf(stderr, "object: no values\n");
+            exit(1);
+        }
+        printf("%-12s %-28s %10zu B %8d tok %9.3f Mlookup/s\n", bench_config, i ? "object/index/random" : "object/get/random",
+               b.n, count, (double)lookups / (t1 - t0) / 1e6);
+    }
+
+    free(toks);
+    free(b.p);
+}
+
+/* Keyed lookups in random records of an array, parse and lookup lines under name */
+static void bench_key_lookups(const char* name, const char* const* keys, int nkeys, int nrecords, const char* value) {
+    enum { NLOOKUPS = 4096 };
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_off_t* recs;
+    jstok_parser p;
+    double t0, t1;
+    long lookups = 0, sum = 0;
+    int order[NLOOKUPS], rec[NLOOKUPS];
+    int count, i, j, k;
+    char label[32];
+
+    buf_puts(&b, "[");
+    for (i = 0; i < nrecords; i++) {
+        buf_puts(&b, i ? ",{" : "{");
+        for (k = 0; k < nkeys; k++) {
+            buf_puts(&b, k ? ",\"" : "\"");
+            buf_puts(&b, keys[k]);
+            buf_puts(&b, "\":");
+            buf_puts(&b, value);
+        }
+        buf_puts(&b, "}");
+    }
+    buf_puts(&b, "]");
+    for (j = 0; j < NLOOKUPS; j++) {
+        order[j] = (int)(((unsigned)bench_rand() << 15 | bench_rand()) % (unsigned)nkeys);
+        rec[j] = (int)(((unsigned)bench_rand() << 15 | bench_rand()) % (unsigned)nrecords);
+    }
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    if (count <= 0) {
+        fprintf(stderr, "%s: parse failed (%d)\n", name, count);
+        exit(1);
+    }
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    snprintf(label, sizeof(label), "%s/parse", name);
+    bench_parse(label, b.p, b.n, toks, count);
+    recs = (jstok_off_t*)malloc((size_t)nrecords * sizeof(*recs));
+    if (jstok_array_index(toks, count, 0, recs, nrecords) != nrecords) {
+        fprintf(stderr, "%s: index failed\n", name);
+        exit(1);
+    }
+
+    t0 = now_sec();
+    do {
+        for (j = 0; j < NLOOKUPS; j++) sum += jstok_object_get(b.p, toks, count, recs[rec[j]], keys[order[j]]);
+        lookups += NLOOKUPS;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    if (sum <= 0) {
+        fprintf(stderr, "%s: no values\n", name);
+        exit(1);
+    }
+    snprintf(label, sizeof(label), "%s/lookup", name);
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Mlookup/s\n", bench_config, label, b.n, count,
+           (double)lookups / (t1 - t0) / 1e6);
+
+    free(recs);
+    free(toks);
+    free(b.p);
+}
+
+/*
+ * keys/long: 32 keys sharing a 38-byte prefix, each pair of the right length
+ * costs a long memcmp unless JSTOK_KEY_HASHES rejects it first. keys/mid: 32
+ * equal-length keys differing only in the middle ("attributes.sizes.value").
+ * keys/short: 16 keys of at most 8 bytes between 40-byte strings over ~20 MB, where each
+ * compared key is a miss into the input unless JSTOK_KEY_PREFIX holds it.
+ */
+static void scenario_keys(void) {
+    static const char* const short_keys[] = {"id",    "name",  "type", "url",   "size",  "ts",   "owner", "group",
+                                             "mode",  "flags", "etag", "state", "score", "tags", "kind",  "parent"};
+    static const char* const mid_words[] = {"sizes", "rates", "codes", "notes", "votes", "types", "modes", "dates",
+                                            "times", "lines", "rules", "roles", "zones", "tones", "nodes", "files",
+                                            "cases", "names", "pages", "tiles", "boxes", "doses", "gates", "hopes",
+                                            "jokes", "kites", "lakes", "mazes", "poles", "ropes", "sales", "wages"};
+    static char long_buf[32][48], mid_buf[32][32];
+    const char* long_keys[32];
+    const char* mid_keys[32];
+    int k;
+
+    for (k = 0; k < 32; k++) {
+        snprintf(long_buf[k], sizeof(long_buf[k]), "com.example.service.settings.parameter_%02d", k);
+        snprintf(mid_buf[k], sizeof(mid_buf[k]), "attributes.%s.value", mid_words[k]);
+        long_keys[k] = long_buf[k];
+        mid_keys[k] = mid_buf[k];
+    }
+    bench_key_lookups("keys/long", long_keys, 32, 1000, "12345");
+    bench_key_lookups("keys/mid", mid_keys, 32, 1000, "12345");
+    bench_key_lookups("keys/short", short_keys, 16, 25000, "\"0123456789abcdef0123456789abcdef01234567\"");
+}
+
+typedef jstok_off_t (*bench_skip_fn)(const jstoktok_t* toks, jstok_off_t count, jstok_off_t i);
+
+static void bench_skips(const char* label, size_t bytes, const jstoktok_t* toks, int count, const int* from, int n,
+                        bench_skip_fn skip) {
+    double t0, t1;
+    long skips = 0, sum = 0;
+    int k;
+
+    t0 = now_sec();
+    do {
+        for (k = 0; k < n; k++) sum += skip(toks, count, from[k]);
+        skips += n;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+
+    if (sum <= 0) {
+        fprintf(stderr, "%s: no skips\n", label);
+        exit(1);
+    }
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Mskip/s\n", bench_config, label, bytes, count,
+           (double)skips / (t1 - t0) / 1e6);
+}
+
+/* jstok_skip vs jstok_skip_fast from each start token, checked to agree first */
+static void bench_skip_pair(const char* name, const bench_buf* b, const jstoktok_t* toks, int count, const int* from,
+                            int n) {
+    char label[64];
+    int k;
+
+    for (k = 0; k < n; k++) {
+        if (jstok_skip(toks, count, from[k]) != jstok_skip_fast(toks, count, from[k])) {
+            fprintf(stderr, "%s: skip mismatch at token %d\n", name, from[k]);
+            exit(1);
+        }
+    }
+    snprintf(label, sizeof(label), "skip/%s/walk", name);
+    bench_skips(label, b->n, toks, count, from, n, jstok_skip);
+    snprintf(label, sizeof(label), "skip/%s/fast", name);
+    bench_skips(label, b->n, toks, count, from, n, jstok_skip_fast);
+}
+
+/*
+ * Subtree skips: the 256 large values of a wide array, every small record
+ * inside them, and every level of a 4000-deep nesting.
+ */
+static void scenario_skip(void) {
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_frame_t* frames;
+    jstok_parser p;
+    int *from, count, n, i, j, k;
+
+    buf_puts(&b, "[");
+    for (i = 0; i < 256; i++) {
+        if (i) buf_puts(&b, ",");
+        corpus_dense(&b, 200);
+    }
+    buf_puts(&b, "]");
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    if (count <= 0) {
+        fprintf(stderr, "skip: parse failed (%d)\n", count);
+        exit(1);
+    }
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    from = (int*)calloc((size_t)count, sizeof(*from));
+    jstok_init(&p);
+    jstok_parse(&p, b.p, (int)b.n, toks, count);
+
+    n = 0;
+    for (i = 1; i < count; i = jstok_skip(toks, count, i)) from[n++] = i;
+    bench_skip_pair("wide", &b, toks, count, from, n);
+
+    n = 0;
+    for (i = 1; i < count; i = jstok_skip(toks, count, i)) {
+        for (k = 0, j = i + 1; k < JSTOK_TOK_SIZE(&toks[i]); k++, j = jstok_skip(toks, count, j)) from[n++] = j;
+    }
+    bench_skip_pair("records", &b, toks, count, from, n);
+    free(from);
+    free(toks);
+    free(b.p);
+
+    /* [0,"s",[1,"s",[2,"s",...]]] */
+    b.n = 0;
+    b.p = NULL;
+    b.cap = 0;
+    for (i = 0; i < 4000; i++) {
+        char lvl[32];
+        snprintf(lvl, sizeof(lvl), "[%d,\"s\",", i);
+        buf_puts(&b, lvl);
+    }
+    buf_puts(&b, "0");
+    for (i = 0; i < 4000; i++) buf_puts(&b, "]");
+
+    frames = (jstok_frame_t*)malloc(4000 * sizeof(*frames));
+    jstok_init_frames(&p, frames, 4000);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    if (count <= 0) {
+        fprintf(stderr, "skip: parse failed (%d)\n", count);
+        exit(1);
+    }
+    toks = (jstoktok_t*)malloc((size_t)count * sizeof(*toks));
+    from = (int*)calloc((size_t)count, sizeof(*from));
+    jstok_init_frames(&p, frames, 4000);
+    jstok_parse(&p, b.p, (int)b.n, toks, count);
+
+    n = 0;
+    for (i = 0; i < count; i++) {
+        if (JSTOK_TOK_TYPE(&toks[i]) == JSTOK_ARRAY) from[n++] = i;
+    }
+    bench_skip_pair("deep", &b, toks, count, from, n);
+    free(from);
+    free(toks);
+    free(frames);
+    free(b.p);
+}
+
+/* The tokens scenario through jstok_parse_soa and the jstok_soa_* helpers */
+static void scenario_soa(void) {
+    bench_buf b = {0};
+    jstok_soa_t soa;
+    jstok_parser p;
+    double t0, t1;
+    long iters = 0, found = 0;
+    int count, i, v, r = 0;
+    size_t bytes;
+
+    corpus_dense(&b, 80000);
+
+    jstok_init(&p);
+    count = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+    bytes = (size_t)count * (1 + 3 * sizeof(jstok_off_t));
+    soa.type = (unsigned char*)malloc((size_t)count);
+    soa.start = (jstok_off_t*)malloc((size_t)count * sizeof(jstok_off_t));
+    soa.end = (jstok_off_t*)malloc((size_t)count * sizeof(jstok_off_t));
+    soa.size = (jstok_off_t*)malloc((size_t)count * sizeof(jstok_off_t));
+    soa.parent = NULL;
+#ifdef JSTOK_FUSED_MEMBERS
+    soa.key = (jstok_off_t*)malloc((size_t)count * sizeof(jstok_off_t));
+    soa.key_end = (jstok_off_t*)malloc((size_t)count * sizeof(jstok_off_t));
+    bytes += (size_t)count * 2 * sizeof(jstok_off_t);
+#endif
+
+    t0 = now_sec();
+    do {
+        jstok_init(&p);
+        r = jstok_parse_soa(&p, b.p, (int)b.n, &soa, count, JSTOK_PARSE_FINAL);
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    if (r != count) {
+        fprintf(stderr, "soa/parse: parse failed (%d at %d)\n", r, p.error_pos);
+        exit(1);
+    }
+    printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, "soa/parse", b.n, r,
+           (double)b.n * (double)iters / (t1 - t0) / 1e9);
+
+    t0 = now_sec();
+    do {
+        for (i = 1; i < count; i = jstok_soa_skip(&soa, count, i)) {
+            v = jstok_soa_object_get(b.p, &soa, count, i, "active");
+            found += v >= 0;
+        }
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+
+    printf("%-12s %-28s %10zu B %8d tok %9.3f Mrec/s\n", bench_config, "soa/lookup", bytes, count,
+           (double)found / (t1 - t0) / 1e6);
+    free(soa.type);
+    free(soa.start);
+    free(soa.end);
+    free(soa.size);
+#ifdef JSTOK_FUSED_MEMBERS
+    free(soa.key);
+    free(soa.key_end);
+#endif
+    free(b.p);
+}
+
+static jstoktok_t* bench_grow(void* user, jstoktok_t* tokens, jstok_off_t* max_tokens) {
+    jstok_off_t cap = *max_tokens ? *max_tokens * 2 : 256;
+    jstoktok_t* t = (jstoktok_t*)realloc(tokens, (size_t)cap * sizeof(*t));
+
+    (void)user;
+    if (t) *max_tokens = cap;
+    return t;
+}
+
+/*
+ * Tokenizing a document of unknown size into a heap array: a counting parse
+ * or a jstok_estimate_tokens scan plus an exact allocation, against one
+ * jstok_parse_grow pass that doubles from 256 tokens.
+ */
+static void scenario_grow(void) {
+    bench_buf b = {0};
+    jstoktok_t* toks;
+    jstok_parser p;
+    jstok_off_t cap;
+    double t0, t1;
+    long iters = 0;
+    int r = 0;
+
+    corpus_dense(&b, 80000);
+
+    t0 = now_sec();
+    do {
+        jstok_init(&p);
+        r = jstok_parse(&p, b.p, (int)b.n, NULL, 0);
+        toks = (jstoktok_t*)malloc((size_t)r * sizeof(*toks));
+        jstok_init(&p);
+        r = jstok_parse(&p, b.p, (int)b.n, toks, r);
+        free(toks);
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, "grow/two_pass", b.n, r,
+           (double)b.n * (double)iters / (t1 - t0) / 1e9);
+
+    iters = 0;
+    t0 = now_sec();
+    do {
+        cap = jstok_estimate_tokens(b.p, (int)b.n);
+        toks = (jstoktok_t*)malloc((size_t)cap * sizeof(*toks));
+        jstok_init(&p);
+        r = jstok_parse(&p, b.p, (int)b.n, toks, cap);
+        free(toks);
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, "grow/estimate", b.n, r,
+           (double)b.n * (double)iters / (t1 - t0) / 1e9);
+
+    iters = 0;
+    t0 = now_sec();
+    do {
+        toks = NULL;
+        cap = 0;
+        jstok_init(&p);
+        r = jstok_parse_grow(&p, b.p, (int)b.n, &toks, &cap, bench_grow, NULL, JSTOK_PARSE_FINAL);
+        free(toks);
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+    if (r < 0) {
+        fprintf(stderr, "grow/one_pass: parse failed (%d at %d)\n", r, p.error_pos);
+        exit(1);
+    }
+    printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, "grow/one_pass", b.n, r,
+           (double)b.n * (double)iters / (t1 - t0) / 1e9);
+    free(b.p);
+}
+
+/* Count-only parse against jstok_estimate_tokens, on token-dense and string-heavy input */
+static void scenario_count(void) {
+    bench_buf b = {0};
+    jstok_parser p;
+    double t0, t1;
+    long iters;
+    int pass, r = 0;
+
+    for (pass = 0; pass < 2; pass++) {
+        const char* label = pass ? "count/strings" : "count/dense";
+
+        b.n = 0;
+        if (pass) {
+            int i;
+            buf_puts(&b, "[");
+            for (i = 0; i < 20000; i++) {
+                char rec[96];
+                snprintf(rec, sizeof(rec), "%s\"%u: lorem ipsum dolor sit amet, \\\"consectetur\\\" adipiscing elit\"",
+                         i ? "," : "", bench_rand());
+                buf_puts(&b, rec);
+            }
+            buf_puts(&b, "]");
+        } else {
+            corpus_dense(&b, 80000);
+        }
+        bench_parse(label, b.p, b.n, NULL, 0);
+
+        iters = 0;
+        t0 = now_sec();
+        do {
+            r = jstok_estimate_tokens(b.p, (int)b.n);
+            iters++;
+            t1 = now_sec();
+        } while (t1 - t0 < BENCH_MIN_SECONDS);
+        jstok_init(&p);
+        if (r != jstok_parse(&p, b.p, (int)b.n, NULL, 0)) {
+            fprintf(stderr, "%s: estimate %d does not match the parse\n", label, r);
+            exit(1);
+        }
+        printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, pass ? "count/strings/estimate" : "count/dense/estimate",
+               b.n, r, (double)b.n * (double)iters / (t1 - t0) / 1e9);
+    }
+    free(b.p);
+}
+
+/*
+ * Many live streams: n parsers each receive one streamed event in 32-byte
+ * chunks, round robin, count-only. Reports parser state per stream, its
+ * total for n streams, and input throughput.
+ */
+static void scenario_streams(void) {
+    static const int counts[] = {10000, 100000, 1000000};
+    static const char event[] = "{\"id\":\"evt_01\",\"choices\":[{\"index\":0,\"delta\":{\"content\":\"Hello, world\","
+                                "\"tool_calls\":[{\"function\":{\"name\":\"f\",\"arguments\":\"{}\"}}]}}],\"usage\":null}";
+    size_t len = sizeof(event) - 1;
+    jstok_parser* ps;
+    char label[64];
+    size_t c;
+    double t0, t1;
+    long iters;
+    int n, i, r = 0;
+
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        n = counts[c];
+        ps = (jstok_parser*)malloc((size_t)n * sizeof(*ps));
+        if (!ps) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+
+        iters = 0;
+        t0 = now_sec();
+        do {
+            size_t have = 0;
+            for (i = 0; i < n; i++) jstok_init(&ps[i]);
+            do {
+                have = have + 32 < len ? have + 32 : len;
+                for (i = 0; i < n; i++) r = jstok_parse_ex(&ps[i], event, (int)have, NULL, 0, have == len);
+            } while (have < len);
+            iters++;
+            t1 = now_sec();
+        } while (t1 - t0 < BENCH_MIN_SECONDS);
+        if (r < 0) {
+            fprintf(stderr, "streams: parse failed (%d)\n", r);
+            exit(1);
+        }
+
+        snprintf(label, sizeof(label), "streams/%d", n);
+        printf("%-12s %-28s %10zu B/parser %9.1f MB %9.3f GB/s\n", bench_config, label, sizeof(*ps),
+               (double)n * (double)sizeof(*ps) / 1e6, (double)len * (double)n * (double)iters / (t1 - t0) / 1e9);
+        free(ps);
+    }
+}
+
+/* Feed a document in growing prefixes of chunk bytes, as a socket reader would */
+static void bench_stream(const char* label, const char* json, size_t len, size_t chunk, jstoktok_t* toks,
+                         int max_tokens) {
+    jstok_parser p;
+    double t0, t1;
+    long iters = 0;
+    int r = 0;
+
+    t0 = now_sec();
+    do {
+        size_t have = 0;
+        jstok_init(&p);
+        do {
+            have = have + chunk < len ? have + chunk : len;
+            r = jstok_parse_ex(&p, json, (int)have, toks, max_tokens, have == len);
+        } while (r == JSTOK_ERROR_PART && have < len);
+        iters++;
+        t1 = now_sec();
+    } while (t1 - t0 < BENCH_MIN_SECONDS);
+
+    if (r < 0) {
+        fprintf(stderr, "%s: parse failed (%d at %d)\n", label, r, p.error_pos);
+        exit(1);
+    }
+
+    printf("%-12s %-28s %10zu B %8d tok %9.3f GB/s\n", bench_config, label, len, r, (double)len * (double)iters / (t1 - t0) / 1e9);
+}
+
+/* A few 256 KB strings arriving in small chunks; cost should not depend on chunk size */
+static void scenario_stream(void) {
+    static const size_t chunks[] = {64, 4096, 65536};
+    bench_buf b = {0};
+    char* body = (char*)malloc(262144);
+    jstoktok_t toks[8];
+    char label[64];
+    size_t i;
+
+    for (i = 0; i < 262144; i++) body[i] = (char)('a' + (i * 7) % 26);
+    body[1000] = '\\';
+    body[1001] = 'n';
+
+    buf_puts(&b, "[");
+    for (i = 0; i < 4; i++) {
+        if (i) buf_puts(&b, ",");
+        buf_puts(&b, "\"");
+        buf_put(&b, body, 262144);
+        buf_puts(&b, "\"");
+    }
+    buf_puts(&b, "]");
+
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        snprintf(label, sizeof(label), "stream/%zu", chunks[i]);
+        bench_stream(label, b.p, b.n, chunks[i], toks, 8);
+    }
+
+    /* Long numbers split by nearly every boundary */
+    b.n = 0;
+    buf_puts(&b, "[");
+    for (i = 0; b.n < (256u << 10); i++) {
+        char num[64];
+        if (i) buf_puts(&b, ",");
+        snprintf(num, sizeof(num), "-%u%u.%u%ue-%u", bench_rand(), bench_rand(), bench_rand(), bench_rand(),
+                 bench_rand() % 300);
+        buf_puts(&b, num);
+    }
+    buf_puts(&b, "]");
+    bench_stream("stream/numbers/8", b.p, b.n, 8, NULL, 0);
+
+    free(body);
+    free(b.p);
+}
+
+typedef struct bench_scenario {
+    const char* name;
+    void (*run)(void);
+} bench_scenario;
+
+static const bench_scenario scenarios[] = {
+    {"strings", scenario_strings},
+    {"indent", scenario_indent},
+    {"scalars", scenario_scalars},
+    {"vectors", scenario_vectors},
+    {"mixed", scenario_mixed},
+    {"stream", scenario_stream},
+    {"tokens", scenario_tokens},
+    {"soa", scenario_soa},
+    {"wide", scenario_wide},
+    {"skip", scenario_skip},
+    {"array", scenario_array},
+    {"object", scenario_object},
+    {"keys", scenario_keys},
+    {"grow", scenario_grow},
+    {"count", scenario_count},
+    {"streams", scenario_streams},
+};
+
+int main(int argc, char** argv) {
+    size_t i;
+    int a;
+
+#ifdef JSTOK_DISPATCH
+    {
+        static const char* const isa_names[] = {"scalar", "sse2", "sse4.2", "avx2", "avx512"};
+        snprintf(bench_config, sizeof(bench_config), "%s/%s", JSTOK_BENCH_CONFIG, isa_names[jstok_get_isa()]);
+    }
+#endif
+
+    for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        int selected = argc < 2;
+        for (a = 1; a < argc; a++) {
+            if (strcmp(argv[a], scenarios[i].name) == 0) selected = 1;
+        }
+        if (selected) scenarios[i].run();
+    }
+    return 0;
+}
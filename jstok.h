@@ -6,6 +6,7 @@
  *   - Strict JSON grammar (optional, recommended)
  *   - Useful token semantics (object.size = pair count, array.size = element count)
  *   - Count-only mode (tokens == NULL)
+ *   - Optional structure-of-arrays output (jstok_parse_soa, jstok_soa_*)
  *   - Incremental-friendly (if you call again with the same buffer + more bytes)
  *   - Tiny helpers for navigating tokens (object get, array at, subtree skip)
  *
@@ -20,15 +21,38 @@
  * Config macros
  *   JSTOK_STATIC             make functions static for embedding
  *   JSTOK_PARENT_LINKS       add token.parent
- *   JSTOK_MAX_DEPTH          nesting depth (default 64)
+ *   JSTOK_SKIP_LINKS         add token.next (index past the subtree), jstok_skip becomes one load
+ *   JSTOK_MAX_DEPTH          frames inside jstok_parser, the nesting depth jstok_init allows (default 64, may be 0)
  *   JSTOK_STRICT             enforce strict JSON (no trailing commas, single top-level value, strict numbers)
  *   JSTOK_NO_HELPERS         omit helper API
+ *   JSTOK_SIMD               SIMD (SSE2/AVX2) or SWAR kernels for string bodies and whitespace
+ *   JSTOK_SIMD_INDEX         two-stage parsing: SSE2/AVX2 structural index in front of the state machine
+ *   JSTOK_SWAR               portable 64-bit SWAR string/whitespace/digit scans and literal compares, no intrinsics
+ *   JSTOK_DISPATCH           implies JSTOK_SIMD, pick SSE2/SSE4.2/AVX2/AVX-512 kernels at runtime (GCC/Clang x86)
+ *   JSTOK_NO_INTRINSICS      never use SIMD intrinsics, even when the target supports them
+ *   JSTOK_NO_COMPUTED_GOTO   dispatch parser actions with a switch instead of computed goto (GCC/Clang)
+ *   JSTOK_LARGE              jstok_off_t (offsets, lengths, token indices, counts) is long long instead of int
+ *   JSTOK_COMPACT_TOKENS     8-byte tokens (type, start, length or size), read them with JSTOK_TOK_*()
+ *   JSTOK_PACKED_FRAMES      one word per nesting level (state + container token index) instead of 12 bytes
+ *   JSTOK_KEY_HASHES         add token.hash (32-bit hash of an object key, 0 for other tokens),
+ *                            jstok_object_get and jstok_path compare it before the key bytes
+ *   JSTOK_KEY_PREFIX         add token.prefix (first 8 bytes of an object key, 0 for other tokens), keys up to
+ *                            8 bytes are matched without reading the input
+ *   JSTOK_FUSED_MEMBERS      no key tokens: an object member is its value token, which carries the key span
+ *                            (JSTOK_TOK_KEY/KEY_END), so objects have size children like arrays
+ *   JSTOK_PRIMITIVE_RUNS     consecutive primitives in an array share one JSTOK_PRIMITIVE_RUN token
+ *                            (span of the run, size = element count), read with jstok_run_next/jstok_array_elem
  *
  * Token boundaries
  *   - start/end are byte offsets into the original json buffer
  *   - end is exclusive, so slice is json[start:end]
  *   - string tokens exclude quotes: start is after ", end is at closing " (exclusive)
  *   - container tokens include delimiters: start at {/[ , end after }/]
+ *   - JSTOK_TOK_TYPE/START/END/SIZE(t) read a token in either layout
+ *   - with JSTOK_FUSED_MEMBERS, JSTOK_TOK_KEY/KEY_END(t) span a member's key
+ *     (quotes excluded), -1 for array elements and top-level values
+ *   - with JSTOK_PRIMITIVE_RUNS, a run token spans its first to its last
+ *     primitive (separators included); array.size still counts elements
  *
  * Return values
  *   >= 0: number of tokens used (or required if tokens == NULL)
@@ -51,6 +75,10 @@ extern "C" {
 #define JSTOK_MAX_DEPTH 64
 #endif
 
+#if defined(JSTOK_DISPATCH) && !defined(JSTOK_SIMD)
+#define JSTOK_SIMD
+#endif
+
 #ifdef JSTOK_STATIC
 #define JSTOK_API static
 #else
@@ -62,7 +90,10 @@ typedef enum {
     JSTOK_OBJECT = 1u << 0,
     JSTOK_ARRAY = 1u << 1,
     JSTOK_STRING = 1u << 2,
-    JSTOK_PRIMITIVE = 1u << 3
+    JSTOK_PRIMITIVE = 1u << 3,
+#ifdef JSTOK_PRIMITIVE_RUNS
+    JSTOK_PRIMITIVE_RUN = 1u << 4 /* two or more consecutive array primitives, size = how many */
+#endif
 } jstoktype_t;
 
 typedef enum {
@@ -72,16 +103,116 @@ typedef enum {
     JSTOK_ERROR_DEPTH = -4
 } jstokerr_t;
 
+/* Byte offsets, token indices and counts; int unless JSTOK_LARGE */
+#ifdef JSTOK_LARGE
+typedef long long jstok_off_t;
+#else
+typedef int jstok_off_t;
+#endif
+
+#ifdef JSTOK_COMPACT_TOKENS
+
+#ifdef JSTOK_LARGE
+#error "JSTOK_COMPACT_TOKENS stores 32-bit offsets and cannot be combined with JSTOK_LARGE"
+#endif
+#ifdef JSTOK_PRIMITIVE_RUNS
+#error "JSTOK_COMPACT_TOKENS has no room for both the span and the element count of a primitive run"
+#endif
+
+/*
+ * 8 bytes per token. info bits 0-1 are log2 of the type, the rest is the
+ * byte length of a string/primitive or the size of an object/array.
+ * Container ends are not kept (JSTOK_TOK_END is -1, jstok_span is empty).
+ * A string or primitive longer than JSTOK_COMPACT_MAX_LEN fails with
+ * JSTOK_ERROR_INVAL.
+ */
+typedef struct jstoktok {
+    unsigned int start;
+    unsigned int info;
+#ifdef JSTOK_PARENT_LINKS
+    jstok_off_t parent;
+#endif
+#ifdef JSTOK_SKIP_LINKS
+    jstok_off_t next;
+#endif
+#ifdef JSTOK_KEY_HASHES
+    unsigned int hash;
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    unsigned long long prefix;
+#endif
+#ifdef JSTOK_FUSED_MEMBERS
+    unsigned int key;     /* key start */
+    unsigned int key_len; /* key length + 1, 0 if not a member */
+#endif
+} jstoktok_t;
+
+#define JSTOK_COMPACT_MAX_LEN 0x3FFFFFFF
+
+#define JSTOK_TOK_TYPE(t) ((jstoktype_t)(1u << ((t)->info & 3u)))
+#define JSTOK_TOK_START(t) ((jstok_off_t)(t)->start)
+#define JSTOK_TOK_END(t) (((t)->info & 2u) ? (jstok_off_t)((t)->start + ((t)->info >> 2)) : -1)
+#define JSTOK_TOK_SIZE(t) (((t)->info & 2u) ? 0 : (jstok_off_t)((t)->info >> 2))
+#ifdef JSTOK_FUSED_MEMBERS
+#define JSTOK_TOK_KEY(t) ((t)->key_len ? (jstok_off_t)(t)->key : -1)
+#define JSTOK_TOK_KEY_END(t) ((t)->key_len ? (jstok_off_t)((t)->key + (t)->key_len - 1u) : -1)
+#endif
+
+#else
+
 typedef struct jstoktok {
     jstoktype_t type;
-    int start;
-    int end;  /* exclusive */
-    int size; /* object: pair count, array: element count, others: 0 */
+    jstok_off_t start;
+    jstok_off_t end;  /* exclusive */
+    jstok_off_t size; /* object: pair count, array: element count, primitive run: element count, others: 0 */
 #ifdef JSTOK_PARENT_LINKS
-    int parent;
+    jstok_off_t parent;
+#endif
+#ifdef JSTOK_SKIP_LINKS
+    jstok_off_t next; /* index just past this token's subtree, -1 while a container is open */
+#endif
+#ifdef JSTOK_KEY_HASHES
+    unsigned int hash; /* object keys: jstok_key_hash of the raw bytes, others: 0 */
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    unsigned long long prefix; /* object keys: first 8 raw bytes, zero-padded, others: 0 */
+#endif
+#ifdef JSTOK_FUSED_MEMBERS
+    jstok_off_t key;     /* member key start (after the quote), -1 if not a member */
+    jstok_off_t key_end; /* exclusive, at the closing quote */
 #endif
 } jstoktok_t;
 
+#define JSTOK_TOK_TYPE(t) ((t)->type)
+#define JSTOK_TOK_START(t) ((t)->start)
+#define JSTOK_TOK_END(t) ((t)->end)
+#define JSTOK_TOK_SIZE(t) ((t)->size)
+#ifdef JSTOK_FUSED_MEMBERS
+#define JSTOK_TOK_KEY(t) ((t)->key)
+#define JSTOK_TOK_KEY_END(t) ((t)->key_end)
+#endif
+
+#endif /* JSTOK_COMPACT_TOKENS */
+
+/*
+ * Structure-of-arrays token sink for jstok_parse_soa: token i is type[i],
+ * start[i], end[i], size[i]. Every column holds max_tokens entries. parent
+ * is optional (NULL skips it) and independent of JSTOK_PARENT_LINKS.
+ * jstok_soa_object_get needs the key columns under JSTOK_FUSED_MEMBERS.
+ * Container ends are stored in every layout.
+ */
+typedef struct jstok_soa {
+    unsigned char* type; /* jstoktype_t */
+    jstok_off_t* start;
+    jstok_off_t* end;
+    jstok_off_t* size;
+    jstok_off_t* parent;
+#ifdef JSTOK_FUSED_MEMBERS
+    jstok_off_t* key; /* optional pair of columns (NULL skips), member key spans, -1 if not a member */
+    jstok_off_t* key_end;
+#endif
+} jstok_soa_t;
+
 /* Parsing states per container frame */
 typedef enum {
     /* Object states */
@@ -97,35 +228,150 @@ typedef enum {
     JSTOK_ST_ARR_COMMA_OR_END
 } jstok_state_t;
 
+#ifdef JSTOK_PACKED_FRAMES
+/*
+ * State in the low 4 bits (the container type follows from it), container
+ * token index + 1 above, 0 in count-only. A container at a token index past
+ * JSTOK_FRAME_TOK_MAX (2^28 - 2 without JSTOK_LARGE, may be defined lower)
+ * fails with JSTOK_ERROR_INVAL, as more tokens would not help.
+ */
+#ifdef JSTOK_LARGE
+typedef unsigned long long jstok_frame_t;
+#else
+typedef unsigned int jstok_frame_t;
+#endif
+#ifndef JSTOK_FRAME_TOK_MAX
+#define JSTOK_FRAME_TOK_MAX ((jstok_off_t)(((jstok_frame_t)-1 >> 4) - 1u))
+#endif
+#else
 typedef struct jstok_frame {
-    jstoktype_t type;
-    jstok_state_t st;
-    int tok; /* token index for this container, or -1 in count-only */
+    jstok_state_t st; /* the container type follows from it */
+    jstok_off_t tok;  /* token index for this container, or -1 in count-only */
+    jstok_off_t size; /* values so far, stored in the token when it closes */
 } jstok_frame_t;
+#endif
+
+#ifdef JSTOK_SIMD_INDEX
+/* Stage-1 index of one 64-byte block, bit n describes json[base + n] (internal) */
+typedef struct jstok_index {
+    jstok_off_t base;
+    int len;                        /* valid bytes in block, 0 = empty */
+    unsigned long long structural;  /* token starts outside strings */
+    unsigned long long stop;        /* '"', '\\' or control byte */
+} jstok_index_t;
+#endif
 
 typedef struct jstok_parser {
-    int pos;       /* current scan position */
-    int toknext;   /* next token index / token count in count-only */
-    int depth;     /* number of active container frames */
-    int root_done; /* parsed one top-level value */
+    jstok_off_t pos;     /* current scan position */
+    jstok_off_t toknext; /* next token index / token count in count-only */
+    int depth;           /* number of active container frames */
+    int root_done;       /* parsed one top-level value */
 
-    int error_pos;
+    jstok_off_t error_pos;
     int error_code;
 
-    jstok_frame_t stack[JSTOK_MAX_DEPTH];
+    jstok_frame_t* stack; /* caller frames, NULL for the inline ones */
+    int max_depth;        /* capacity of the frames in use */
+
+    /* Token cut off by the end of a non-final chunk, pos is rewound to its start */
+    jstok_off_t part_start; /* first byte of that token, -1 if none */
+    jstok_off_t part_scan;  /* bytes before this were already validated */
+    int part_phase;         /* where in the token part_scan is, JSTOK_PART_* */
+
+    const jstok_soa_t* soa; /* column sink, only valid during one jstok_parse_soa call */
+
+#ifdef JSTOK_FUSED_MEMBERS
+    jstok_off_t key_start; /* span of the last key, for the value token that follows it */
+    jstok_off_t key_end;
+#endif
+#ifdef JSTOK_PRIMITIVE_RUNS
+    jstok_off_t run; /* token of the array primitive just parsed, the next one extends it; -1 if none */
+#endif
+
+#ifdef JSTOK_SIMD_INDEX
+    jstok_index_t ix; /* block cache, only valid during one jstok_parse_ex call */
+#endif
+
+#if JSTOK_MAX_DEPTH > 0
+    jstok_frame_t frames[JSTOK_MAX_DEPTH]; /* used while stack is NULL */
+#endif
 } jstok_parser;
 
 JSTOK_API void jstok_init(jstok_parser* p);
 
+/*
+ * jstok_init with caller-owned frames: max_depth is the nesting limit and
+ * frames must hold that many and outlive the parse. Lets JSTOK_MAX_DEPTH stay
+ * small (even 0) while some parsers accept deep documents.
+ */
+JSTOK_API void jstok_init_frames(jstok_parser* p, jstok_frame_t* frames, int max_depth);
+
 typedef enum {
     /* Input chunk is the final end-of-stream segment. */
     JSTOK_PARSE_FINAL = 1u << 0
 } jstok_parse_flags_t;
 
-JSTOK_API int jstok_parse_ex(jstok_parser* p, const char* json, int json_len, jstoktok_t* tokens, int max_tokens,
-                             unsigned flags);
+JSTOK_API jstok_off_t jstok_parse_ex(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* tokens,
+                                     jstok_off_t max_tokens, unsigned flags);
+
+JSTOK_API jstok_off_t jstok_parse(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* tokens,
+                                  jstok_off_t max_tokens);
+
+/*
+ * Token space for jstok_parse_grow. Return an array of more than *max_tokens
+ * entries that keeps the existing ones (realloc semantics) and store its size
+ * in *max_tokens. Returning NULL or no more room ends with JSTOK_ERROR_NOMEM.
+ */
+typedef jstoktok_t* (*jstok_grow_fn)(void* user, jstoktok_t* tokens, jstok_off_t* max_tokens);
+
+/*
+ * jstok_parse_ex that asks grow for more tokens when *tokens is full and
+ * carries on from there, so an unknown document needs one pass. *tokens may
+ * start NULL. On return *tokens and *max_tokens hold the current array.
+ */
+JSTOK_API jstok_off_t jstok_parse_grow(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t** tokens,
+                                       jstok_off_t* max_tokens, jstok_grow_fn grow, void* user, unsigned flags);
+
+/*
+ * jstok_parse_ex into columns instead of jstoktok_t, soa == NULL counts only.
+ * Keep to one kind of sink for all calls on a parser.
+ */
+JSTOK_API jstok_off_t jstok_parse_soa(jstok_parser* p, const char* json, jstok_off_t json_len, const jstok_soa_t* soa,
+                                      jstok_off_t max_tokens, unsigned flags);
+
+/*
+ * Token count of json from a block-at-a-time structural scan instead of the
+ * parser: containers, strings and primitive runs outside strings. Exact for
+ * valid JSON and never below what jstok_parse accepts, so it sizes a token
+ * array without a counting parse. Nothing is validated. With
+ * JSTOK_FUSED_MEMBERS keys still count, so it is an upper bound, one over per
+ * object member. So it is with JSTOK_PRIMITIVE_RUNS, which counts every
+ * primitive of a run.
+ */
+JSTOK_API jstok_off_t jstok_estimate_tokens(const char* json, jstok_off_t json_len);
+
+#ifdef JSTOK_DISPATCH
+
+typedef enum {
+    JSTOK_ISA_SCALAR = 0,
+    JSTOK_ISA_SSE2,
+    JSTOK_ISA_SSE42,
+    JSTOK_ISA_AVX2,
+    JSTOK_ISA_AVX512
+} jstok_isa_t;
+
+/*
+ * Rebind the SIMD kernels to isa, capped at what the CPU supports.
+ * Returns the level now in use. At startup the best level is bound, or the
+ * one named by the JSTOK_ISA environment variable
+ * (scalar, sse2, sse4.2, avx2, avx512). Not thread-safe against running parses.
+ */
+JSTOK_API jstok_isa_t jstok_set_isa(jstok_isa_t isa);
+
+/* Level currently bound */
+JSTOK_API jstok_isa_t jstok_get_isa(void);
 
-JSTOK_API int jstok_parse(jstok_parser* p, const char* json, int json_len, jstoktok_t* tokens, int max_tokens);
+#endif
 
 #ifndef JSTOK_NO_HELPERS
 
@@ -141,13 +387,65 @@ JSTOK_API jstok_span_t jstok_span(const char* json, const jstoktok_t* t);
 JSTOK_API int jstok_eq(const char* json, const jstoktok_t* t, const char* s);
 
 /* Skip token subtree, returns index of next sibling or count on end */
-JSTOK_API int jstok_skip(const jstoktok_t* toks, int count, int i);
+JSTOK_API jstok_off_t jstok_skip(const jstoktok_t* toks, jstok_off_t count, jstok_off_t i);
+
+/*
+ * jstok_skip that binary-searches the ascending token starts for the
+ * container's end instead of walking its children, O(log n); short
+ * containers scan the starts. Open containers, compact tokens and
+ * JSTOK_SKIP_LINKS use jstok_skip.
+ */
+JSTOK_API jstok_off_t jstok_skip_fast(const jstoktok_t* toks, jstok_off_t count, jstok_off_t i);
+
+/*
+ * Parent index of every token into parent[0..count-1], -1 at the top level,
+ * the same values JSTOK_PARENT_LINKS stores, also for token arrays cut by PART
+ * or NOMEM. Two linear passes, no extra memory. With JSTOK_COMPACT_TOKENS a
+ * trailing key whose value has no token yet counts as a sibling of its
+ * object. Returns 0 on success.
+ */
+JSTOK_API int jstok_build_parents(const jstoktok_t* toks, jstok_off_t count, jstok_off_t* parent);
+
+/* Get array element i (0-based), returns token index (a primitive run's for an element inside one) or -1 */
+JSTOK_API jstok_off_t jstok_array_at(const jstoktok_t* toks, jstok_off_t count, jstok_off_t arr_tok, jstok_off_t idx);
 
-/* Get array element i (0-based), returns token index or -1 */
-JSTOK_API int jstok_array_at(const jstoktok_t* toks, int count, int arr_tok, int idx);
+/*
+ * Token index of every element of array arr_tok into index[], in one pass,
+ * for repeated random access; the elements of a primitive run all map to
+ * the run. Returns the element count (fewer if count cuts the array), or -1
+ * if arr_tok is no array or cap is below its size.
+ */
+JSTOK_API jstok_off_t jstok_array_index(const jstoktok_t* toks, jstok_off_t count, jstok_off_t arr_tok, jstok_off_t* index,
+                                        jstok_off_t cap);
+
+/* Element idx from an index of n elements, returns token index or -1 */
+JSTOK_API jstok_off_t jstok_array_index_at(const jstok_off_t* index, jstok_off_t n, jstok_off_t idx);
 
 /* Get object value by key, returns value token index or -1 */
-JSTOK_API int jstok_object_get(const char* json, const jstoktok_t* toks, int count, int obj_tok, const char* key);
+JSTOK_API jstok_off_t jstok_object_get(const char* json, const jstoktok_t* toks, jstok_off_t count, jstok_off_t obj_tok,
+                                     const char* key);
+
+/* Hash table over the keys of one object, see jstok_object_index */
+typedef struct jstok_object_index {
+    const char* json;
+    const jstoktok_t* toks;
+    jstok_off_t* slots;        /* key (or fused member) token index, -1 when empty */
+    jstok_off_t mask;          /* slot count - 1 */
+    unsigned long long k0, k1; /* SipHash key from the seed */
+} jstok_object_index_t;
+
+/*
+ * Index the keys of object obj_tok in nslots caller slots, a power of two
+ * above the key count (twice it keeps probes short). Keys hash with
+ * SipHash-1-3 under seed, so a per-process random seed keeps crafted key
+ * sets from colliding. Returns 0, or -1 if obj_tok is no object or nslots
+ * does not fit.
+ */
+JSTOK_API int jstok_object_index(jstok_object_index_t* ix, const char* json, const jstoktok_t* toks, jstok_off_t count,
+                                 jstok_off_t obj_tok, jstok_off_t* slots, jstok_off_t nslots, unsigned long long seed);
+
+/* Value token of key (key_len bytes, raw as in the JSON) in O(1) expected, or -1; duplicates give the first */
+JSTOK_API jstok_off_t jstok_object_index_get(const jstok_object_index_t* ix, const char* key, size_t key_len);
 
 /* Parse primitive token as integer (base 10), returns 0 on success */
 JSTOK_API int jstok_atoi64(const char* json, const jstoktok_t* t, long long* out);
@@ -164,7 +462,31 @@ JSTOK_API int jstok_unescape(const char* json, const jstoktok_t* t, char* out, s
  * - If current node is Array: expects (int) index.
  * * Example: jstok_path(json, toks, count, root, "choices", 0, "message", NULL);
  */
-JSTOK_API int jstok_path(const char* json, const jstoktok_t* toks, int count, int root, ...);
+JSTOK_API jstok_off_t jstok_path(const char* json, const jstoktok_t* toks, jstok_off_t count, jstok_off_t root, ...);
+
+#ifdef JSTOK_PRIMITIVE_RUNS
+/*
+ * Elements of a primitive run (or of a lone primitive) one at a time: start
+ * with *pos = JSTOK_TOK_START(t), each call stores the next element in *out
+ * as a JSTOK_PRIMITIVE token (jstok_atoi64, jstok_eq, ... take it), moves
+ * *pos past it and returns 1. Returns 0 after the last element.
+ */
+JSTOK_API int jstok_run_next(const char* json, const jstoktok_t* t, jstok_off_t* pos, jstoktok_t* out);
+
+/*
+ * Array element idx as a token in *out: a copy of its own token, or for an
+ * element inside a primitive run that one primitive, found by counting the
+ * run's commas. Returns the token index, as jstok_array_at, or -1.
+ */
+JSTOK_API jstok_off_t jstok_array_elem(const char* json, const jstoktok_t* toks, jstok_off_t count, jstok_off_t arr_tok,
+                                       jstok_off_t idx, jstoktok_t* out);
+#endif
+
+/* jstok_skip, jstok_array_at and jstok_object_get over jstok_parse_soa columns */
+JSTOK_API jstok_off_t jstok_soa_skip(const jstok_soa_t* soa, jstok_off_t count, jstok_off_t i);
+JSTOK_API jstok_off_t jstok_soa_array_at(const jstok_soa_t* soa, jstok_off_t count, jstok_off_t arr_tok, jstok_off_t idx);
+JSTOK_API jstok_off_t jstok_soa_object_get(const char* json, const jstok_soa_t* soa, jstok_off_t count,
+                                           jstok_off_t obj_tok, const char* key);
 
 typedef enum { JSTOK_SSE_EOF = 0, JSTOK_SSE_DATA = 1, JSTOK_SSE_NEED_MORE = -1 } jstok_sse_res;
 
@@ -193,6 +515,10 @@ JSTOK_API jstok_sse_res jstok_sse_next(const char* buf, size_t len, size_t* pos,
 #include <limits.h>
 #include <string.h>
 
+#ifdef JSTOK_DISPATCH
+#include <stdlib.h>
+#endif
+
 /* Minimal helpers, avoid heavy deps */
 #define jstok_is_space(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
 
@@ -275,192 +601,1173 @@ static const unsigned char jstok_delim_class[256] = {
 #define jstok_is_hex(c) (jstok_hex_class[(unsigned char)(c)] != 0u)
 #define jstok_is_delim(c) (jstok_delim_class[(unsigned char)(c)] != 0u)
 
-static void jstok_set_error(jstok_parser* p, int code, int pos) {
-    p->error_code = code;
-    p->error_pos = pos;
+/* Kernels for other instruction sets stay compiled but may be unreferenced */
+#if defined(__GNUC__) || defined(__clang__)
+#define JSTOK_MAYBE_UNUSED __attribute__((unused))
+#define JSTOK_NOINLINE __attribute__((noinline, cold)) /* and keep calls off the hot path */
+#define JSTOK_INLINE __inline__ __attribute__((always_inline))
+#define jstok_ctz64(x) __builtin_ctzll(x)
+#ifdef __POPCNT__
+#define jstok_popcount64(x) __builtin_popcountll(x)
+#endif
+#else
+#define JSTOK_MAYBE_UNUSED
+#define JSTOK_NOINLINE
+#define JSTOK_INLINE
+static JSTOK_MAYBE_UNUSED int jstok_ctz64(unsigned long long x) {
+    int n = 0;
+    while ((x & 1ULL) == 0ULL) {
+        x >>= 1;
+        n++;
+    }
+    return n;
 }
+#endif
 
-JSTOK_API void jstok_init(jstok_parser* p) {
-    if (!p) return;
-    p->pos = 0;
-    p->toknext = 0;
-    p->depth = 0;
-    p->root_done = 0;
-    p->error_pos = -1;
-    p->error_code = 0;
+#ifndef jstok_popcount64
+static JSTOK_MAYBE_UNUSED int jstok_popcount64(unsigned long long x) {
+    x -= (x >> 1) & 0x5555555555555555ULL;
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
 }
+#endif
 
-static int jstok_push(jstok_parser* p, jstoktype_t type, jstok_state_t st, int tok) {
-    if (p->depth >= JSTOK_MAX_DEPTH) {
-        jstok_set_error(p, JSTOK_ERROR_DEPTH, p->pos);
-        return JSTOK_ERROR_DEPTH;
+#if defined(JSTOK_SIMD) || defined(JSTOK_SIMD_INDEX)
+
+/*
+ * Kernel selection. Normally the best instruction set enabled at compile
+ * time is used. With JSTOK_DISPATCH on GCC/Clang x86 every kernel is built
+ * with a target attribute and bound at startup to what the CPU supports.
+ */
+#if defined(JSTOK_DISPATCH) && !defined(JSTOK_NO_INTRINSICS) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define JSTOK_DISPATCH_X86 1
+#define JSTOK_HAVE_SSE2 1
+#define JSTOK_HAVE_SSE42 1
+#define JSTOK_HAVE_AVX2 1
+#define JSTOK_HAVE_AVX512 1
+#define JSTOK_TARGET(isa) __attribute__((target(isa)))
+#else
+#ifndef JSTOK_NO_INTRINSICS
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define JSTOK_HAVE_AVX512 1
+#endif
+#if defined(__AVX2__)
+#define JSTOK_HAVE_AVX2 1
+#endif
+#if defined(__SSE4_2__)
+#define JSTOK_HAVE_SSE42 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSTOK_HAVE_SSE2 1
+#endif
+#endif
+#define JSTOK_TARGET(isa)
+#endif
+
+#if defined(JSTOK_HAVE_SSE2)
+#include <immintrin.h>
+#endif
+
+#endif /* JSTOK_SIMD || JSTOK_SIMD_INDEX */
+
+/*
+ * Stage 1: classify a 64-byte block into per-byte bitmaps. Used by the
+ * JSTOK_SIMD_INDEX parser and by jstok_estimate_tokens.
+ *   quote   '"'
+ *   bslash  '\\'
+ *   space   JSON whitespace
+ *   op      { } [ ] : ,
+ *   open    { [
+ *   ctrl    bytes < 0x20
+ */
+typedef struct jstok_block {
+    unsigned long long quote;
+    unsigned long long bslash;
+    unsigned long long space;
+    unsigned long long op;
+    unsigned long long open;
+    unsigned long long ctrl;
+} jstok_block_t;
+
+static JSTOK_MAYBE_UNUSED void jstok_classify64_scalar(const unsigned char* s, jstok_block_t* b) {
+    int i;
+
+    memset(b, 0, sizeof(*b));
+    for (i = 0; i < 64; i++) {
+        unsigned long long bit = 1ULL << i;
+        unsigned char cls = jstok_classify(s[i]);
+
+        if (cls == JSTOK_CC_SPACE) {
+            b->space |= bit;
+        } else if (cls == JSTOK_CC_QUOTE) {
+            b->quote |= bit;
+        } else if (cls != JSTOK_CC_OTHER) {
+            b->op |= bit;
+            if (cls == JSTOK_CC_LBRACE || cls == JSTOK_CC_LBRACKET) b->open |= bit;
+        }
+        if (s[i] == '\\') b->bslash |= bit;
+        if (s[i] < 0x20) b->ctrl |= bit;
     }
-    p->stack[p->depth].type = type;
-    p->stack[p->depth].st = st;
-    p->stack[p->depth].tok = tok;
-    p->depth++;
-    return 0;
 }
 
-static void jstok_pop(jstok_parser* p) {
-    if (p->depth > 0) {
-        p->depth--;
+#if defined(JSTOK_HAVE_SSE2)
+
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("sse2") void jstok_classify64_sse2(const unsigned char* s, jstok_block_t* b) {
+    int k;
+
+    memset(b, 0, sizeof(*b));
+    for (k = 0; k < 4; k++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(s + 16 * k));
+        __m128i lo = _mm_or_si128(v, _mm_set1_epi8(0x20)); /* folds [ ] onto { } */
+        __m128i sp = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        __m128i open = _mm_cmpeq_epi8(lo, _mm_set1_epi8('{'));
+        __m128i op = _mm_or_si128(_mm_or_si128(open, _mm_cmpeq_epi8(lo, _mm_set1_epi8('}'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        __m128i ctrl = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+        int sh = 16 * k;
+
+        b->quote |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << sh;
+        b->bslash |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << sh;
+        b->space |= (unsigned long long)(unsigned)_mm_movemask_epi8(sp) << sh;
+        b->op |= (unsigned long long)(unsigned)_mm_movemask_epi8(op) << sh;
+        b->open |= (unsigned long long)(unsigned)_mm_movemask_epi8(open) << sh;
+        b->ctrl |= (unsigned long long)(unsigned)_mm_movemask_epi8(ctrl) << sh;
     }
 }
 
-static jstok_frame_t* jstok_top(jstok_parser* p) {
-    if (p->depth <= 0) return (jstok_frame_t*)0;
-    return &p->stack[p->depth - 1];
-}
+#endif
 
-static int jstok_new_token(jstok_parser* p, jstoktok_t* toks, int max_tokens, jstoktype_t type, int start, int end,
-                           int parent) {
-    int idx;
+#if defined(JSTOK_HAVE_AVX2)
 
-    if (toks) {
-        if (p->toknext >= max_tokens) {
-            jstok_set_error(p, JSTOK_ERROR_NOMEM, p->pos);
-            return JSTOK_ERROR_NOMEM;
-        }
-        idx = p->toknext++;
-        toks[idx].type = type;
-        toks[idx].start = start;
-        toks[idx].end = end;
-        toks[idx].size = 0;
-#ifdef JSTOK_PARENT_LINKS
-        toks[idx].parent = parent;
-#else
-        (void)parent;
-#endif
-        return idx;
-    }
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("avx2") void jstok_classify64_avx2(const unsigned char* s, jstok_block_t* b) {
+    int k;
 
-    /* Count-only mode */
-    idx = p->toknext++;
-    (void)type;
-    (void)start;
-    (void)end;
-    (void)parent;
-    return idx;
+    memset(b, 0, sizeof(*b));
+    for (k = 0; k < 2; k++) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(const void*)(s + 32 * k));
+        __m256i lo = _mm256_or_si256(v, _mm256_set1_epi8(0x20)); /* folds [ ] onto { } */
+        __m256i sp = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        __m256i open = _mm256_cmpeq_epi8(lo, _mm256_set1_epi8('{'));
+        __m256i op = _mm256_or_si256(_mm256_or_si256(open, _mm256_cmpeq_epi8(lo, _mm256_set1_epi8('}'))),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+        __m256i ctrl = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F));
+        int sh = 32 * k;
+
+        b->quote |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << sh;
+        b->bslash |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << sh;
+        b->space |= (unsigned long long)(unsigned)_mm256_movemask_epi8(sp) << sh;
+        b->op |= (unsigned long long)(unsigned)_mm256_movemask_epi8(op) << sh;
+        b->open |= (unsigned long long)(unsigned)_mm256_movemask_epi8(open) << sh;
+        b->ctrl |= (unsigned long long)(unsigned)_mm256_movemask_epi8(ctrl) << sh;
+    }
 }
 
-static void jstok_inc_container_size(jstok_parser* p, jstoktok_t* toks) {
-    jstok_frame_t* fr = jstok_top(p);
-    if (!fr) return;
-    if (!toks) return;
-    if (fr->tok < 0) return;
-    toks[fr->tok].size++;
+#endif
+
+#if defined(JSTOK_HAVE_AVX512)
+
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("avx512f,avx512bw") void jstok_classify64_avx512(const unsigned char* s, jstok_block_t* b) {
+    __m512i v = _mm512_loadu_si512((const void*)s);
+    __m512i lo = _mm512_or_si512(v, _mm512_set1_epi8(0x20)); /* folds [ ] onto { } */
+
+    b->quote = (unsigned long long)_mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"'));
+    b->bslash = (unsigned long long)_mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'));
+    b->space = (unsigned long long)(_mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' ')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\t')) |
+                                    _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\r')));
+    b->open = (unsigned long long)_mm512_cmpeq_epi8_mask(lo, _mm512_set1_epi8('{'));
+    b->op = b->open | (unsigned long long)(_mm512_cmpeq_epi8_mask(lo, _mm512_set1_epi8('}')) |
+                                           _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(':')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(',')));
+    b->ctrl = (unsigned long long)_mm512_cmplt_epu8_mask(v, _mm512_set1_epi8(0x20));
 }
 
-static void jstok_rollback_accept_value(jstok_parser* p, jstoktok_t* toks, jstok_frame_t* fr, jstok_state_t saved_st,
-                                        int saved_root_done) {
-    if (fr) {
-        fr->st = saved_st;
-        if (toks && fr->tok >= 0 && toks[fr->tok].size > 0) {
-            toks[fr->tok].size--;
-        }
-    } else {
-        p->root_done = saved_root_done;
+#endif
+
+/* First '"', '\\' or control byte at or after pos, json_len if none */
+static jstok_off_t jstok_scan_string_scalar(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (pos < json_len) {
+        char c = json[pos];
+        if (c == '"' || c == '\\' || (unsigned char)c < 0x20) break;
+        pos++;
     }
+    return pos;
 }
 
-static int jstok_accept_value(jstok_parser* p, jstoktok_t* toks) {
-    jstok_frame_t* fr = jstok_top(p);
+#ifndef JSTOK_SIMD_INDEX /* the structural index already skips whitespace */
 
-    if (!fr) {
-#ifdef JSTOK_STRICT
-        if (p->root_done) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-#endif
-        p->root_done = 1;
-        return 0;
+/* First non-whitespace byte at or after pos, json_len if none */
+static jstok_off_t jstok_skip_space_scalar(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (pos < json_len && jstok_classify(json[pos]) == JSTOK_CC_SPACE) {
+        pos++;
     }
+    return pos;
+}
 
-    if (fr->type == JSTOK_ARRAY) {
-        if (fr->st != JSTOK_ST_ARR_VALUE_OR_END && fr->st != JSTOK_ST_ARR_VALUE) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-        jstok_inc_container_size(p, toks);
-        fr->st = JSTOK_ST_ARR_COMMA_OR_END;
-        return 0;
-    }
+#endif
 
-    if (fr->type == JSTOK_OBJECT) {
-        if (fr->st != JSTOK_ST_OBJ_VALUE) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-        jstok_inc_container_size(p, toks);
-        fr->st = JSTOK_ST_OBJ_COMMA_OR_END;
-        return 0;
-    }
+#ifdef JSTOK_SIMD
 
-    jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-    return JSTOK_ERROR_INVAL;
-}
+/*
+ * String body kernels test a whole vector for '"', '\\' and bytes < 0x20 at
+ * once and only locate the byte when something matched. Whitespace kernels
+ * handle indentation runs; the caller has already seen one space, so
+ * minified input (single separators) never reaches them. Tails shorter than
+ * one vector go through the next narrower kernel.
+ */
+#if defined(JSTOK_HAVE_SSE2)
 
-static int jstok_accept_key(jstok_parser* p) {
-    jstok_frame_t* fr = jstok_top(p);
-    if (!fr || fr->type != JSTOK_OBJECT) {
-        jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-        return JSTOK_ERROR_INVAL;
-    }
-    if (fr->st != JSTOK_ST_OBJ_KEY_OR_END && fr->st != JSTOK_ST_OBJ_KEY) {
-        jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-        return JSTOK_ERROR_INVAL;
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("sse2") jstok_off_t jstok_scan_string_sse2(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+
+    while (json_len - pos >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(json + pos));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)), _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+        unsigned bits = (unsigned)_mm_movemask_epi8(m);
+
+        if (bits) return pos + jstok_ctz64(bits);
+        pos += 16;
     }
-    fr->st = JSTOK_ST_OBJ_COLON;
-    return 0;
+    return jstok_scan_string_scalar(json, json_len, pos);
 }
 
-static int jstok_parse_string_token(jstok_parser* p, const char* json, int json_len, jstoktok_t* toks, int max_tokens,
-                                    int parent) {
-    int start_quote;
-    int i;
+#ifndef JSTOK_SIMD_INDEX
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("sse2") jstok_off_t jstok_skip_space_sse2(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (json_len - pos >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(json + pos));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        unsigned bits = ~(unsigned)_mm_movemask_epi8(ws) & 0xFFFFu;
 
-    start_quote = p->pos;
-    if (p->pos >= json_len || json[p->pos] != '"') {
-        jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-        return JSTOK_ERROR_INVAL;
+        if (bits) return pos + jstok_ctz64(bits);
+        pos += 16;
     }
+    return jstok_skip_space_scalar(json, json_len, pos);
+}
+#endif
 
-    p->pos++; /* after opening quote */
+#endif
 
-    while (p->pos < json_len) {
-        char c;
+#if defined(JSTOK_HAVE_SSE42) && !defined(JSTOK_SIMD_INDEX)
 
-        while (p->pos < json_len) {
-            c = json[p->pos];
-            if (c == '"' || c == '\\' || (unsigned char)c < 0x20) break;
-            p->pos++;
-        }
+/*
+ * Whitespace as a PCMPESTRI byte set. String bodies stay on the SSE2 kernel:
+ * PCMPESTRI's latency loses to compare + movemask on long runs.
+ */
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("sse4.2") jstok_off_t jstok_skip_space_sse42(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    const __m128i ws = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
 
-        if (p->pos >= json_len) break;
+    while (json_len - pos >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(const void*)(json + pos));
+        int i = _mm_cmpestri(ws, 4, v, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT);
 
-        c = json[p->pos];
+        if (i < 16) return pos + i;
+        pos += 16;
+    }
+    return jstok_skip_space_scalar(json, json_len, pos);
+}
 
-        if ((unsigned char)c < 0x20) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
+#endif
 
-        if (c == '"') {
-            /* end exclusive is at the closing quote position */
-            i = jstok_new_token(p, toks, max_tokens, JSTOK_STRING, start_quote + 1, p->pos, parent);
-            if (i < 0) return i;
-            p->pos++; /* consume closing quote */
-            return i;
-        }
+#if defined(JSTOK_HAVE_AVX2)
 
-        if (c == '\\') {
-            p->pos++;
-            if (p->pos >= json_len) {
-                jstok_set_error(p, JSTOK_ERROR_PART, p->pos);
-                p->pos = start_quote; /* Rewind for resume */
-                return JSTOK_ERROR_PART;
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("avx2") jstok_off_t jstok_scan_string_avx2(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i bslash = _mm256_set1_epi8('\\');
+    const __m256i ctrl = _mm256_set1_epi8(0x1F);
+
+    while (json_len - pos >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(const void*)(json + pos));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash)), _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl));
+        unsigned bits = (unsigned)_mm256_movemask_epi8(m);
+
+        if (bits) return pos + jstok_ctz64(bits);
+        pos += 32;
+    }
+    return jstok_scan_string_sse2(json, json_len, pos);
+}
+
+#ifndef JSTOK_SIMD_INDEX
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("avx2") jstok_off_t jstok_skip_space_avx2(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (json_len - pos >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(const void*)(json + pos));
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        unsigned bits = ~(unsigned)_mm256_movemask_epi8(ws);
+
+        if (bits) return pos + jstok_ctz64(bits);
+        pos += 32;
+    }
+    return jstok_skip_space_sse2(json, json_len, pos);
+}
+#endif
+
+#endif
+
+#if defined(JSTOK_HAVE_AVX512)
+
+/* 64 bytes per step, the tail is a masked load so there is no scalar loop */
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("avx512f,avx512bw") jstok_off_t jstok_scan_string_avx512(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    const __m512i quote = _mm512_set1_epi8('"');
+    const __m512i bslash = _mm512_set1_epi8('\\');
+    const __m512i space = _mm512_set1_epi8(0x20);
+
+    while (pos < json_len) {
+        jstok_off_t n = json_len - pos;
+        __mmask64 live = n >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << n) - 1);
+        __m512i v = _mm512_maskz_loadu_epi8(live, json + pos);
+        unsigned long long bits = (unsigned long long)((_mm512_cmpeq_epi8_mask(v, quote) | _mm512_cmpeq_epi8_mask(v, bslash) | _mm512_cmplt_epu8_mask(v, space)) & live);
+
+        if (bits) return pos + jstok_ctz64(bits);
+        pos += 64;
+    }
+    return json_len;
+}
+
+#ifndef JSTOK_SIMD_INDEX
+static JSTOK_MAYBE_UNUSED JSTOK_TARGET("avx512f,avx512bw") jstok_off_t jstok_skip_space_avx512(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (pos < json_len) {
+        jstok_off_t n = json_len - pos;
+        __mmask64 live = n >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << n) - 1);
+        __m512i v = _mm512_maskz_loadu_epi8(live, json + pos);
+        __mmask64 ws = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' ')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\t')) |
+                       _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n')) | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\r'));
+        unsigned long long bits = (unsigned long long)(~ws & live);
+
+        if (bits) return pos + jstok_ctz64(bits);
+        pos += 64;
+    }
+    return json_len;
+}
+#endif
+
+#endif
+
+#endif /* JSTOK_SIMD */
+
+/*
+ * SWAR kernels: 8 bytes per step in a plain 64-bit register, no ISA
+ * dependency. The lowest flagged byte of each mask is exact, so little-endian
+ * targets locate a match with ctz; others finish with the byte loop.
+ */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define JSTOK_SWAR_LE 1
+#elif defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+#define JSTOK_SWAR_LE 1
+#endif
+
+#define JSTOK_SWAR_ONES 0x0101010101010101ULL
+#define JSTOK_SWAR_HIGH 0x8080808080808080ULL
+
+/* Nonzero if any byte of w is < n (n <= 0x80), exact as a yes/no answer */
+#define jstok_swar_has_less(w, n) (((w) - JSTOK_SWAR_ONES * (n)) & ~(w) & JSTOK_SWAR_HIGH)
+#define jstok_swar_has_byte(w, b) jstok_swar_has_less((w) ^ (JSTOK_SWAR_ONES * (b)), 1u)
+
+/* 0x80 in exactly the bytes of w equal to b */
+#define jstok_swar_eq(w, b) jstok_swar_zero_bytes((w) ^ (JSTOK_SWAR_ONES * (b)))
+
+static JSTOK_MAYBE_UNUSED unsigned long long jstok_swar_zero_bytes(unsigned long long x) {
+    const unsigned long long low7 = 0x7F7F7F7F7F7F7F7FULL;
+    return ~(((x & low7) + low7) | x | low7);
+}
+
+static JSTOK_MAYBE_UNUSED jstok_off_t jstok_scan_string_swar(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (json_len - pos >= 8) {
+        unsigned long long w, m;
+
+        memcpy(&w, json + pos, sizeof(w));
+        m = jstok_swar_has_byte(w, '"') | jstok_swar_has_byte(w, '\\') | jstok_swar_has_less(w, 0x20u);
+        if (m) {
+#ifdef JSTOK_SWAR_LE
+            return pos + (jstok_ctz64(m) >> 3);
+#else
+            break;
+#endif
+        }
+        pos += 8;
+    }
+    return jstok_scan_string_scalar(json, json_len, pos);
+}
+
+#ifndef JSTOK_SIMD_INDEX
+static JSTOK_MAYBE_UNUSED jstok_off_t jstok_skip_space_swar(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (json_len - pos >= 8) {
+        unsigned long long w, m;
+
+        memcpy(&w, json + pos, sizeof(w));
+        m = ~(jstok_swar_eq(w, ' ') | jstok_swar_eq(w, '\t') | jstok_swar_eq(w, '\n') | jstok_swar_eq(w, '\r')) & JSTOK_SWAR_HIGH;
+        if (m) {
+#ifdef JSTOK_SWAR_LE
+            return pos + (jstok_ctz64(m) >> 3);
+#else
+            break;
+#endif
+        }
+        pos += 8;
+    }
+    return jstok_skip_space_scalar(json, json_len, pos);
+}
+#endif
+
+#ifdef JSTOK_SWAR_LE
+
+/* Bit n = high bit of byte n, for masks from jstok_swar_eq */
+#define jstok_swar_pack(m) ((((m) >> 7) * 0x0102040810204080ULL) >> 56)
+
+/* Stage-1 block classifier for builds without vector intrinsics */
+static JSTOK_MAYBE_UNUSED void jstok_classify64_swar(const unsigned char* s, jstok_block_t* b) {
+    int k;
+
+    memset(b, 0, sizeof(*b));
+    for (k = 0; k < 8; k++) {
+        unsigned long long w, lo, open, op, sp;
+        int sh = 8 * k;
+
+        memcpy(&w, s + sh, sizeof(w));
+        lo = w | (JSTOK_SWAR_ONES * 0x20u); /* folds [ ] onto { } */
+        open = jstok_swar_eq(lo, '{');
+        op = open | jstok_swar_eq(lo, '}') | jstok_swar_eq(w, ':') | jstok_swar_eq(w, ',');
+        sp = jstok_swar_eq(w, ' ') | jstok_swar_eq(w, '\t') | jstok_swar_eq(w, '\n') | jstok_swar_eq(w, '\r');
+
+        b->quote |= jstok_swar_pack(jstok_swar_eq(w, '"')) << sh;
+        b->bslash |= jstok_swar_pack(jstok_swar_eq(w, '\\')) << sh;
+        b->space |= jstok_swar_pack(sp) << sh;
+        b->op |= jstok_swar_pack(op) << sh;
+        b->open |= jstok_swar_pack(open) << sh;
+        b->ctrl |= jstok_swar_pack(jstok_swar_zero_bytes(w & (JSTOK_SWAR_ONES * 0xE0u))) << sh;
+    }
+}
+
+#endif
+
+#ifdef JSTOK_SWAR
+
+/* 0x80 in exactly the bytes of w that are '0'..'9' */
+static unsigned long long jstok_swar_digits(unsigned long long w) {
+    unsigned long long hi3 = jstok_swar_zero_bytes((w & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL);
+    unsigned long long lo_gt9 = ((w & 0x0F0F0F0F0F0F0F0FULL) + 0x0606060606060606ULL) & 0x1010101010101010ULL;
+    return hi3 & ~(lo_gt9 << 3);
+}
+
+/* First non-digit at or after i, json_len if none */
+static jstok_off_t jstok_skip_digits_swar(const char* json, jstok_off_t json_len, jstok_off_t i) {
+    while (json_len - i >= 8) {
+        unsigned long long w, m;
+
+        memcpy(&w, json + i, sizeof(w));
+        m = ~jstok_swar_digits(w) & JSTOK_SWAR_HIGH;
+        if (m) {
+#ifdef JSTOK_SWAR_LE
+            return i + (jstok_ctz64(m) >> 3);
+#else
+            break;
+#endif
+        }
+        i += 8;
+    }
+    while (i < json_len && jstok_is_digit(json[i])) i++;
+    return i;
+}
+
+/* true/null/false in one 4-byte compare (plus one byte for false), no memcmp call */
+static int jstok_word_match(const char* s, const char* lit, int lit_len) {
+    unsigned long a = 0UL, b = 0UL;
+
+    memcpy(&a, s, 4);
+    memcpy(&b, lit, 4);
+    return a == b && (lit_len == 4 || s[4] == lit[4]);
+}
+
+#endif /* JSTOK_SWAR */
+
+#ifdef JSTOK_DISPATCH_X86
+
+/* Kernels bound once at startup, see jstok_set_isa() */
+typedef struct jstok_kernels {
+    jstok_isa_t isa;
+    jstok_off_t (*scan_string)(const char* json, jstok_off_t json_len, jstok_off_t pos);
+    void (*classify64)(const unsigned char* s, jstok_block_t* b);
+#ifndef JSTOK_SIMD_INDEX
+    jstok_off_t (*skip_space)(const char* json, jstok_off_t json_len, jstok_off_t pos);
+#endif
+} jstok_kernels_t;
+
+static jstok_kernels_t jstok_kern = {
+    JSTOK_ISA_SCALAR,
+    jstok_scan_string_scalar,
+    jstok_classify64_scalar,
+#ifndef JSTOK_SIMD_INDEX
+    jstok_skip_space_scalar,
+#endif
+};
+
+static jstok_isa_t jstok_cpu_isa(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return JSTOK_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2")) return JSTOK_ISA_AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return JSTOK_ISA_SSE42;
+    if (__builtin_cpu_supports("sse2")) return JSTOK_ISA_SSE2;
+    return JSTOK_ISA_SCALAR;
+}
+
+JSTOK_API jstok_isa_t jstok_set_isa(jstok_isa_t isa) {
+    jstok_isa_t cpu = jstok_cpu_isa();
+
+    if (isa > cpu) isa = cpu;
+    if (isa < JSTOK_ISA_SCALAR) isa = JSTOK_ISA_SCALAR;
+
+    switch (isa) {
+        case JSTOK_ISA_AVX512:
+            jstok_kern.scan_string = jstok_scan_string_avx512;
+            jstok_kern.classify64 = jstok_classify64_avx512;
+#ifndef JSTOK_SIMD_INDEX
+            jstok_kern.skip_space = jstok_skip_space_avx512;
+#endif
+            break;
+        case JSTOK_ISA_AVX2:
+            jstok_kern.scan_string = jstok_scan_string_avx2;
+            jstok_kern.classify64 = jstok_classify64_avx2;
+#ifndef JSTOK_SIMD_INDEX
+            jstok_kern.skip_space = jstok_skip_space_avx2;
+#endif
+            break;
+        case JSTOK_ISA_SSE42:
+            jstok_kern.scan_string = jstok_scan_string_sse2;
+            jstok_kern.classify64 = jstok_classify64_sse2;
+#ifndef JSTOK_SIMD_INDEX
+            jstok_kern.skip_space = jstok_skip_space_sse42;
+#endif
+            break;
+        case JSTOK_ISA_SSE2:
+            jstok_kern.scan_string = jstok_scan_string_sse2;
+            jstok_kern.classify64 = jstok_classify64_sse2;
+#ifndef JSTOK_SIMD_INDEX
+            jstok_kern.skip_space = jstok_skip_space_sse2;
+#endif
+            break;
+        default:
+            jstok_kern.scan_string = jstok_scan_string_scalar;
+            jstok_kern.classify64 = jstok_classify64_scalar;
+#ifndef JSTOK_SIMD_INDEX
+            jstok_kern.skip_space = jstok_skip_space_scalar;
+#endif
+            break;
+    }
+    jstok_kern.isa = isa;
+    return isa;
+}
+
+JSTOK_API jstok_isa_t jstok_get_isa(void) {
+    return jstok_kern.isa;
+}
+
+/* Best level the CPU supports, or the one named by JSTOK_ISA */
+__attribute__((constructor)) static void jstok_dispatch_init(void) {
+    static const char* const names[] = {"scalar", "sse2", "sse4.2", "avx2", "avx512"};
+    const char* env = getenv("JSTOK_ISA");
+    jstok_isa_t isa = JSTOK_ISA_AVX512;
+    int i;
+
+    if (env) {
+        for (i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+            if (strcmp(env, names[i]) == 0) isa = (jstok_isa_t)i;
+        }
+    }
+    jstok_set_isa(isa);
+}
+
+#define jstok_scan_string_vec(json, json_len, pos) jstok_kern.scan_string(json, json_len, pos)
+#define jstok_skip_space_vec(json, json_len, pos) jstok_kern.skip_space(json, json_len, pos)
+#define jstok_classify64(s, b) jstok_kern.classify64(s, b)
+
+#else /* !JSTOK_DISPATCH_X86: best kernel enabled at compile time */
+
+#ifdef JSTOK_DISPATCH
+/* No runtime dispatch on this target, report the compile-time selection */
+JSTOK_API jstok_isa_t jstok_set_isa(jstok_isa_t isa) {
+    (void)isa;
+#if defined(JSTOK_HAVE_AVX512)
+    return JSTOK_ISA_AVX512;
+#elif defined(JSTOK_HAVE_AVX2)
+    return JSTOK_ISA_AVX2;
+#elif defined(JSTOK_HAVE_SSE42)
+    return JSTOK_ISA_SSE42;
+#elif defined(JSTOK_HAVE_SSE2)
+    return JSTOK_ISA_SSE2;
+#else
+    return JSTOK_ISA_SCALAR;
+#endif
+}
+
+JSTOK_API jstok_isa_t jstok_get_isa(void) {
+    return jstok_set_isa(JSTOK_ISA_SCALAR);
+}
+#endif
+
+#if !defined(JSTOK_SIMD) && defined(JSTOK_SWAR)
+#define jstok_scan_string_vec jstok_scan_string_swar
+#define jstok_skip_space_vec jstok_skip_space_swar
+#elif !defined(JSTOK_SIMD)
+#define jstok_scan_string_vec jstok_scan_string_scalar
+#define jstok_skip_space_vec jstok_skip_space_scalar
+#elif defined(JSTOK_HAVE_AVX512)
+#define jstok_scan_string_vec jstok_scan_string_avx512
+#define jstok_skip_space_vec jstok_skip_space_avx512
+#elif defined(JSTOK_HAVE_AVX2)
+#define jstok_scan_string_vec jstok_scan_string_avx2
+#define jstok_skip_space_vec jstok_skip_space_avx2
+#elif defined(JSTOK_HAVE_SSE42)
+#define jstok_scan_string_vec jstok_scan_string_sse2
+#define jstok_skip_space_vec jstok_skip_space_sse42
+#elif defined(JSTOK_HAVE_SSE2)
+#define jstok_scan_string_vec jstok_scan_string_sse2
+#define jstok_skip_space_vec jstok_skip_space_sse2
+#else
+#define jstok_scan_string_vec jstok_scan_string_swar
+#define jstok_skip_space_vec jstok_skip_space_swar
+#endif
+
+#if defined(JSTOK_HAVE_AVX512)
+#define jstok_classify64 jstok_classify64_avx512
+#elif defined(JSTOK_HAVE_AVX2)
+#define jstok_classify64 jstok_classify64_avx2
+#elif defined(JSTOK_HAVE_SSE2)
+#define jstok_classify64 jstok_classify64_sse2
+#elif defined(JSTOK_SWAR_LE)
+#define jstok_classify64 jstok_classify64_swar
+#else
+#define jstok_classify64 jstok_classify64_scalar
+#endif
+
+#endif /* JSTOK_DISPATCH_X86 */
+
+/*
+ * Bytes escaped by a backslash. *carry is 1 if the block starts escaped and
+ * is updated for the block that follows.
+ */
+static unsigned long long jstok_escaped64(unsigned long long bs, unsigned long long* carry) {
+    const unsigned long long even = 0x5555555555555555ULL;
+    unsigned long long follows, odd_starts, seq;
+
+    bs &= ~*carry;
+    follows = (bs << 1) | *carry;
+    odd_starts = bs & ~even & ~follows;
+    seq = odd_starts + bs; /* runs starting on an odd bit carry out past their end */
+    *carry = seq < bs;
+    return (even ^ (seq << 1)) & follows;
+}
+
+/* Bit n = parity of set bits 0..n, turns quote positions into string regions */
+static unsigned long long jstok_prefix_xor64(unsigned long long x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+#ifdef JSTOK_SIMD_INDEX
+
+/*
+ * Index the block at json[base]. base must be a token boundary (outside any
+ * string), which holds for every position stage 2 asks about, so the block
+ * needs no carry from its predecessor. The tail is padded with spaces.
+ */
+static void jstok_index_block(jstok_index_t* ix, const char* json, jstok_off_t json_len, jstok_off_t base) {
+    unsigned char pad[64];
+    const unsigned char* s = (const unsigned char*)json + base;
+    jstok_block_t b;
+    unsigned long long quote, in_str, scalar, esc = 0ULL;
+    int n = json_len - base < 64 ? (int)(json_len - base) : 64;
+
+    if (n < 64) {
+        memset(pad, ' ', sizeof(pad));
+        memcpy(pad, s, (size_t)n);
+        s = pad;
+    }
+
+    jstok_classify64(s, &b);
+
+    quote = b.quote & ~jstok_escaped64(b.bslash, &esc);
+    in_str = jstok_prefix_xor64(quote); /* includes opening quote, excludes closing */
+    scalar = ~(b.op | b.space | b.quote) & ~in_str;
+
+    ix->base = base;
+    ix->len = n;
+    ix->structural = (b.op & ~in_str) | (quote & in_str) | (scalar & ~(scalar << 1));
+    ix->stop = b.quote | b.bslash | b.ctrl;
+}
+
+/* Stage 2: next token start at or after pos, json_len if only whitespace remains */
+static jstok_off_t jstok_index_next(jstok_index_t* ix, const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    while (pos < json_len) {
+        unsigned long long bits;
+
+        if (pos < ix->base || pos >= ix->base + ix->len) {
+            jstok_index_block(ix, json, json_len, pos);
+        }
+        bits = ix->structural >> (pos - ix->base);
+        if (bits) return pos + jstok_ctz64(bits);
+        pos = ix->base + ix->len; /* rest of block is whitespace, next one starts clean */
+    }
+    return json_len;
+}
+
+/* String body scan, answered from the cached block while it covers pos */
+static jstok_off_t jstok_index_scan_string(const jstok_index_t* ix, const char* json, jstok_off_t json_len,
+                                           jstok_off_t pos) {
+    if (pos >= ix->base && pos < ix->base + ix->len) {
+        unsigned long long bits = ix->stop >> (pos - ix->base);
+        if (bits) return pos + jstok_ctz64(bits);
+        pos = ix->base + ix->len;
+    }
+    return jstok_scan_string_vec(json, json_len, pos);
+}
+#define jstok_scan_string(p, json, json_len, pos) jstok_index_scan_string(&(p)->ix, json, json_len, pos)
+
+#else
+
+#define jstok_scan_string(p, json, json_len, pos) jstok_scan_string_vec(json, json_len, pos)
+
+#if defined(JSTOK_SIMD) || defined(JSTOK_SWAR)
+static jstok_off_t jstok_skip_space(const char* json, jstok_off_t json_len, jstok_off_t pos) {
+    if (pos >= json_len || jstok_classify(json[pos]) != JSTOK_CC_SPACE) return pos;
+    return jstok_skip_space_vec(json, json_len, pos + 1);
+}
+#else
+#define jstok_skip_space jstok_skip_space_scalar
+#endif
+
+#endif /* JSTOK_SIMD_INDEX */
+
+static void jstok_set_error(jstok_parser* p, int code, jstok_off_t pos) {
+    p->error_code = code;
+    p->error_pos = pos;
+}
+
+JSTOK_API void jstok_init(jstok_parser* p) {
+    if (!p) return;
+    p->pos = 0;
+    p->toknext = 0;
+    p->depth = 0;
+    p->root_done = 0;
+    p->error_pos = -1;
+    p->error_code = 0;
+    p->part_start = -1;
+    p->part_scan = 0;
+    p->part_phase = 0;
+    p->soa = (const jstok_soa_t*)0;
+#ifdef JSTOK_FUSED_MEMBERS
+    p->key_start = -1;
+    p->key_end = -1;
+#endif
+#ifdef JSTOK_PRIMITIVE_RUNS
+    p->run = -1;
+#endif
+    p->stack = (jstok_frame_t*)0;
+    p->max_depth = JSTOK_MAX_DEPTH;
+#ifdef JSTOK_SIMD_INDEX
+    p->ix.base = 0;
+    p->ix.len = 0;
+#endif
+}
+
+JSTOK_API void jstok_init_frames(jstok_parser* p, jstok_frame_t* frames, int max_depth) {
+    if (!p) return;
+    jstok_init(p);
+    p->stack = frames;
+    p->max_depth = frames && max_depth > 0 ? max_depth : 0;
+}
+
+#ifdef JSTOK_PACKED_FRAMES
+#define jstok_frame_st(fr) ((jstok_state_t)(*(fr) & 15u))
+#define jstok_frame_set_st(fr, s) (*(fr) = (*(fr) & ~(jstok_frame_t)15u) | (jstok_frame_t)(s))
+#define jstok_frame_tok(fr) ((jstok_off_t)(*(fr) >> 4) - 1)
+#else
+#define jstok_frame_st(fr) ((fr)->st)
+#define jstok_frame_set_st(fr, s) ((fr)->st = (s))
+#define jstok_frame_tok(fr) ((fr)->tok)
+#endif
+/* Frames in use, resolved on each access so a parser can be moved between calls */
+#if JSTOK_MAX_DEPTH > 0
+#define jstok_frames(p) ((p)->stack ? (p)->stack : (p)->frames)
+#else
+#define jstok_frames(p) ((p)->stack)
+#endif
+#define jstok_frame_type(fr) (jstok_frame_st(fr) >= JSTOK_ST_ARR_VALUE_OR_END ? JSTOK_ARRAY : JSTOK_OBJECT)
+
+static int jstok_push(jstok_parser* p, jstok_state_t st, jstok_off_t tok) {
+    if (p->depth >= p->max_depth) {
+        jstok_set_error(p, JSTOK_ERROR_DEPTH, p->pos);
+        return JSTOK_ERROR_DEPTH;
+    }
+#ifdef JSTOK_PACKED_FRAMES
+    if (tok > JSTOK_FRAME_TOK_MAX) {
+        jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
+        return JSTOK_ERROR_INVAL;
+    }
+    jstok_frames(p)[p->depth] = ((jstok_frame_t)(tok + 1) << 4) | (jstok_frame_t)st;
+#else
+    jstok_frames(p)[p->depth].st = st;
+    jstok_frames(p)[p->depth].tok = tok;
+    jstok_frames(p)[p->depth].size = 0;
+#endif
+    p->depth++;
+    return 0;
+}
+
+static void jstok_pop(jstok_parser* p) {
+    if (p->depth > 0) {
+        p->depth--;
+    }
+}
+
+static jstok_frame_t* jstok_top(jstok_parser* p) {
+    if (p->depth <= 0) return (jstok_frame_t*)0;
+    return &jstok_frames(p)[p->depth - 1];
+}
+
+/* Column writes, out of line so the jstoktok_t path of jstok_new_token stays as small as before */
+static JSTOK_NOINLINE jstok_off_t jstok_new_soa_token(jstok_parser* p, jstok_off_t max_tokens, jstoktype_t type,
+                                                      jstok_off_t start, jstok_off_t end, jstok_off_t parent) {
+    jstok_off_t idx;
+
+    if (p->toknext >= max_tokens) {
+        jstok_set_error(p, JSTOK_ERROR_NOMEM, p->pos);
+        return JSTOK_ERROR_NOMEM;
+    }
+    idx = p->toknext++;
+    p->soa->type[idx] = (unsigned char)type;
+    p->soa->start[idx] = start;
+    p->soa->end[idx] = end;
+    p->soa->size[idx] = 0;
+    if (p->soa->parent) p->soa->parent[idx] = parent;
+#ifdef JSTOK_FUSED_MEMBERS
+    if (p->soa->key) p->soa->key[idx] = p->soa->key_end[idx] = -1;
+#endif
+    return idx;
+}
+
+static JSTOK_INLINE jstok_off_t jstok_new_token(jstok_parser* p, jstoktok_t* toks, jstok_off_t max_tokens, jstoktype_t type,
+                                   jstok_off_t start, jstok_off_t end, jstok_off_t parent) {
+    jstok_off_t idx;
+
+#ifdef JSTOK_COMPACT_TOKENS
+    if (end - start > JSTOK_COMPACT_MAX_LEN) {
+        jstok_set_error(p, JSTOK_ERROR_INVAL, start);
+        return JSTOK_ERROR_INVAL;
+    }
+#endif
+
+    if (toks) {
+        if (p->toknext >= max_tokens) {
+            jstok_set_error(p, JSTOK_ERROR_NOMEM, p->pos);
+            return JSTOK_ERROR_NOMEM;
+        }
+        idx = p->toknext++;
+#ifdef JSTOK_COMPACT_TOKENS
+        /* low bits are log2 of the type, containers start with size 0 */
+        toks[idx].start = (unsigned int)start;
+        if (end < 0) {
+            toks[idx].info = type == JSTOK_OBJECT ? 0u : 1u;
+        } else {
+            toks[idx].info = (unsigned int)(end - start) << 2 | (type == JSTOK_STRING ? 2u : 3u);
+        }
+#else
+        toks[idx].type = type;
+        toks[idx].start = start;
+        toks[idx].end = end;
+        toks[idx].size = 0;
+#endif
+#ifdef JSTOK_PARENT_LINKS
+        toks[idx].parent = parent;
+#else
+        (void)parent;
+#endif
+#ifdef JSTOK_SKIP_LINKS
+        toks[idx].next = end < 0 ? -1 : idx + 1; /* containers are linked when they close */
+#endif
+#ifdef JSTOK_KEY_HASHES
+        toks[idx].hash = 0; /* keys are hashed once they close */
+#endif
+#ifdef JSTOK_KEY_PREFIX
+        toks[idx].prefix = 0;
+#endif
+#ifdef JSTOK_FUSED_MEMBERS
+#ifdef JSTOK_COMPACT_TOKENS
+        toks[idx].key = 0;
+        toks[idx].key_len = 0;
+#else
+        toks[idx].key = -1;
+        toks[idx].key_end = -1;
+#endif
+#endif
+        return idx;
+    }
+
+    if (p->soa) return jstok_new_soa_token(p, max_tokens, type, start, end, parent);
+
+    /* Count-only mode */
+    idx = p->toknext++;
+    (void)type;
+    (void)start;
+    (void)end;
+    (void)parent;
+    return idx;
+}
+
+#ifndef JSTOK_PACKED_FRAMES
+/* Store the running sizes of the open containers, before returning mid-document */
+static void jstok_store_sizes(jstok_parser* p, jstoktok_t* toks) {
+    int d;
+
+    for (d = 0; d < p->depth; d++) {
+        const jstok_frame_t* fr = &jstok_frames(p)[d];
+
+        if (fr->tok < 0) continue;
+        if (toks) {
+#ifdef JSTOK_COMPACT_TOKENS
+            toks[fr->tok].info = (toks[fr->tok].info & 3u) | (unsigned int)fr->size << 2;
+#else
+            toks[fr->tok].size = fr->size;
+#endif
+        } else if (p->soa) {
+            p->soa->size[fr->tok] = fr->size;
+        }
+    }
+}
+#endif
+
+/* The count stays in the frame until the container closes, a packed frame has no room for it */
+static void jstok_inc_container_size(jstok_parser* p, jstoktok_t* toks) {
+    jstok_frame_t* fr = jstok_top(p);
+#ifdef JSTOK_PACKED_FRAMES
+    jstok_off_t tok;
+
+    if (!fr) return;
+    tok = jstok_frame_tok(fr);
+    if (tok < 0) return;
+    if (toks) {
+#ifdef JSTOK_COMPACT_TOKENS
+        toks[tok].info += 4u;
+#else
+        toks[tok].size++;
+#endif
+    } else if (p->soa) {
+        p->soa->size[tok]++;
+    }
+#else
+    (void)toks;
+    if (fr) fr->size++;
+#endif
+}
+
+static void jstok_rollback_accept_value(jstok_parser* p, jstoktok_t* toks, jstok_frame_t* fr, jstok_state_t saved_st,
+                                        int saved_root_done) {
+    if (fr) {
+        jstok_off_t tok = jstok_frame_tok(fr);
+
+        jstok_frame_set_st(fr, saved_st);
+#ifndef JSTOK_PACKED_FRAMES
+        (void)tok;
+        (void)toks;
+        fr->size--;
+#else
+        if (p->soa && tok >= 0 && p->soa->size[tok] > 0) {
+            p->soa->size[tok]--;
+        } else if (toks && tok >= 0 && JSTOK_TOK_SIZE(&toks[tok]) > 0) {
+#ifdef JSTOK_COMPACT_TOKENS
+            toks[tok].info -= 4u;
+#else
+            toks[tok].size--;
+#endif
+        }
+#endif
+    } else {
+        p->root_done = saved_root_done;
+    }
+}
+
+/*
+ * Transition table: state x character class -> action. It holds every
+ * grammar check, so the actions in jstok_parse_ex only do the work. Rows are
+ * the frame states plus the top level, columns the JSTOK_CC_* classes.
+ */
+#define JSTOK_ST_ROOT 0      /* no open container */
+#define JSTOK_ST_ROOT_DONE 9 /* strict mode, top-level value already parsed */
+
+enum {
+    JSTOK_A_INVAL = 0,
+    JSTOK_A_PRIMITIVE,
+    JSTOK_A_STRING,
+    JSTOK_A_KEY,
+    JSTOK_A_OBJECT,
+    JSTOK_A_ARRAY,
+    JSTOK_A_OBJECT_END,
+    JSTOK_A_ARRAY_END,
+    JSTOK_A_COLON,
+    JSTOK_A_OBJECT_COMMA,
+    JSTOK_A_ARRAY_COMMA
+};
+
+#define JSTOK_A_VALUE_ROW(array_end)                                                                      \
+    {JSTOK_A_PRIMITIVE, JSTOK_A_INVAL, JSTOK_A_OBJECT, JSTOK_A_INVAL, JSTOK_A_ARRAY, (array_end), JSTOK_A_INVAL, \
+     JSTOK_A_INVAL, JSTOK_A_STRING}
+
+static const unsigned char jstok_transitions[10][9] = {
+    /*                     OTHER SPACE { } [ ] : , QUOTE */
+    /* ROOT             */ JSTOK_A_VALUE_ROW(JSTOK_A_INVAL),
+    /* OBJ_KEY_OR_END   */ {0, 0, 0, JSTOK_A_OBJECT_END, 0, 0, 0, 0, JSTOK_A_KEY},
+    /* OBJ_KEY          */ {0, 0, 0, 0, 0, 0, 0, 0, JSTOK_A_KEY},
+    /* OBJ_COLON        */ {0, 0, 0, 0, 0, 0, JSTOK_A_COLON, 0, 0},
+    /* OBJ_VALUE        */ JSTOK_A_VALUE_ROW(JSTOK_A_INVAL),
+    /* OBJ_COMMA_OR_END */ {0, 0, 0, JSTOK_A_OBJECT_END, 0, 0, 0, JSTOK_A_OBJECT_COMMA, 0},
+    /* ARR_VALUE_OR_END */ JSTOK_A_VALUE_ROW(JSTOK_A_ARRAY_END),
+    /* ARR_VALUE        */ JSTOK_A_VALUE_ROW(JSTOK_A_INVAL),
+    /* ARR_COMMA_OR_END */ {0, 0, 0, 0, 0, JSTOK_A_ARRAY_END, 0, JSTOK_A_ARRAY_COMMA, 0},
+    /* ROOT_DONE        */ {0, 0, 0, 0, 0, 0, 0, 0, 0},
+};
+
+/* State after a value, indexed by the state that accepted it */
+static const unsigned char jstok_after_value[10] = {
+#ifdef JSTOK_STRICT
+    JSTOK_ST_ROOT_DONE,
+#else
+    JSTOK_ST_ROOT,
+#endif
+    0, 0, 0, JSTOK_ST_OBJ_COMMA_OR_END, 0, JSTOK_ST_ARR_COMMA_OR_END, JSTOK_ST_ARR_COMMA_OR_END, 0, 0,
+};
+
+/* Row of jstok_transitions for the current position */
+static int jstok_state(const jstok_parser* p) {
+    if (p->depth > 0) return (int)jstok_frame_st(&jstok_frames(p)[p->depth - 1]);
+#ifdef JSTOK_STRICT
+    if (p->root_done) return JSTOK_ST_ROOT_DONE;
+#endif
+    return JSTOK_ST_ROOT;
+}
+
+/* Record a value in its parent, the transition table has already allowed it */
+static void jstok_accept_value(jstok_parser* p, jstoktok_t* toks) {
+    jstok_frame_t* fr = jstok_top(p);
+
+    if (!fr) {
+        p->root_done = 1;
+        return;
+    }
+    jstok_inc_container_size(p, toks);
+    jstok_frame_set_st(fr, jstok_frame_type(fr) == JSTOK_ARRAY ? JSTOK_ST_ARR_COMMA_OR_END : JSTOK_ST_OBJ_COMMA_OR_END);
+}
+
+/* Resume points of a token cut off by a non-final chunk */
+enum {
+    JSTOK_PART_NONE = 0,
+    JSTOK_PART_STRING,
+    JSTOK_PART_LITERAL,  /* part_scan is after the matched prefix */
+    JSTOK_PART_NUM_SIGN, /* after '-' */
+    JSTOK_PART_NUM_ZERO, /* after a leading '0' */
+    JSTOK_PART_NUM_INT,
+    JSTOK_PART_NUM_DOT, /* after '.' */
+    JSTOK_PART_NUM_FRAC,
+    JSTOK_PART_NUM_E, /* after 'e' or 'E' */
+    JSTOK_PART_NUM_EXP_SIGN,
+    JSTOK_PART_NUM_EXP
+};
+
+static void jstok_set_part(jstok_parser* p, jstok_off_t start, jstok_off_t scan, int phase) {
+    p->part_start = start;
+    p->part_scan = scan;
+    p->part_phase = phase;
+}
+
+#ifdef JSTOK_KEY_HASHES
+/*
+ * 32-bit hash of a key's length and its first, middle and last 8 bytes,
+ * constant cost however long the key. Keys up to 24 bytes are covered
+ * whole; longer keys that differ only between those words collide and are
+ * told apart by the memcmp that follows a match. Native byte order: stored
+ * and looked up hashes come from the same build.
+ */
+static JSTOK_INLINE unsigned int jstok_key_hash(const char* s, size_t n) {
+    unsigned long long a, b, m;
+    size_t i;
+
+    if (n >= 8) {
+        memcpy(&a, s, sizeof(a));
+        memcpy(&m, s + n / 2 - 4, sizeof(m));
+        memcpy(&b, s + n - 8, sizeof(b));
+    } else {
+        for (a = 0, i = 0; i < n; i++) a = a << 8 | (unsigned char)s[i];
+        b = m = 0;
+    }
+    a = (a + n) * 0x9E3779B97F4A7C15ULL ^ b * 0xBF58476D1CE4E5B9ULL ^ m * 0x94D049BB133111EBULL; /* independent multiplies */
+    return (unsigned int)(a >> 32 ^ a);
+}
+#endif
+
+#ifdef JSTOK_KEY_PREFIX
+/* First 8 bytes of a key in one word, zero-padded (native byte order, compared only for equality) */
+static JSTOK_INLINE unsigned long long jstok_key_prefix(const char* s, size_t n) {
+    unsigned long long w = 0;
+    size_t i;
+
+    if (n >= 8) {
+        memcpy(&w, s, sizeof(w));
+    } else {
+        for (i = 0; i < n; i++) ((unsigned char*)&w)[i] = (unsigned char)s[i];
+    }
+    return w;
+}
+#endif
+
+/* Validate the string at p->pos up to its closing quote and return that position, p->pos stays on it */
+static JSTOK_INLINE jstok_off_t jstok_scan_string_token(jstok_parser* p, const char* json, jstok_off_t json_len) {
+    jstok_off_t start_quote;
+    jstok_off_t esc;
+    jstok_off_t i;
+
+    start_quote = p->pos;
+    if (p->pos >= json_len || json[p->pos] != '"') {
+        jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
+        return JSTOK_ERROR_INVAL;
+    }
+
+    p->pos++; /* after opening quote */
+
+    /* Continue a string cut off by the previous chunk instead of rescanning it */
+    if (p->part_start == start_quote && p->part_phase == JSTOK_PART_STRING && p->part_scan > p->pos) {
+        p->pos = p->part_scan;
+    }
+    p->part_start = -1;
+
+    while (p->pos < json_len) {
+        char c;
+
+        p->pos = jstok_scan_string(p, json, json_len, p->pos);
+
+        if (p->pos >= json_len) break;
+
+        c = json[p->pos];
+
+        if ((unsigned char)c < 0x20) {
+            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
+            return JSTOK_ERROR_INVAL;
+        }
+
+        if (c == '"') return p->pos;
+
+        if (c == '\\') {
+            esc = p->pos;
+            p->pos++;
+            if (p->pos >= json_len) {
+                p->pos = esc; /* escape is rescanned as a whole */
+                break;
             }
             c = json[p->pos];
 
@@ -473,16 +1780,16 @@ static int jstok_parse_string_token(jstok_parser* p, const char* json, int json_
                 /* \uXXXX */
                 for (i = 0; i < 4; i++) {
                     p->pos++;
-                    if (p->pos >= json_len) {
-                        jstok_set_error(p, JSTOK_ERROR_PART, p->pos);
-                        p->pos = start_quote; /* Rewind for resume */
-                        return JSTOK_ERROR_PART;
-                    }
+                    if (p->pos >= json_len) break;
                     if (!jstok_is_hex(json[p->pos])) {
                         jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
                         return JSTOK_ERROR_INVAL;
                     }
                 }
+                if (p->pos >= json_len) {
+                    p->pos = esc;
+                    break;
+                }
                 p->pos++;
                 continue;
             }
@@ -494,25 +1801,110 @@ static int jstok_parse_string_token(jstok_parser* p, const char* json, int json_
         p->pos++;
     }
 
-    jstok_set_error(p, JSTOK_ERROR_PART, p->pos);
+    jstok_set_error(p, JSTOK_ERROR_PART, json_len);
+    jstok_set_part(p, start_quote, p->pos, JSTOK_PART_STRING);
     p->pos = start_quote; /* Rewind for resume */
     return JSTOK_ERROR_PART;
 }
 
-static int jstok_parse_literal(jstok_parser* p, const char* json, int json_len, const char* lit, int lit_len,
+static jstok_off_t jstok_parse_string_token(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* toks,
+                                            jstok_off_t max_tokens, jstok_off_t parent) {
+    jstok_off_t start_quote = p->pos;
+    jstok_off_t end = jstok_scan_string_token(p, json, json_len);
+    jstok_off_t i;
+
+    if (end < 0) return end;
+
+    /* end exclusive is at the closing quote position */
+    i = jstok_new_token(p, toks, max_tokens, JSTOK_STRING, start_quote + 1, end, parent);
+    if (i == JSTOK_ERROR_NOMEM) {
+        /* a retry starts at the quote again (keys have no caller to rewind them) but skips the body */
+        jstok_set_part(p, start_quote, end, JSTOK_PART_STRING);
+        p->pos = start_quote;
+    }
+    if (i < 0) return i;
+    p->pos++; /* consume closing quote */
+    return i;
+}
+
+#ifdef JSTOK_FUSED_MEMBERS
+/* A key emits no token, its span waits in the parser for the value */
+static jstok_off_t jstok_parse_key(jstok_parser* p, const char* json, jstok_off_t json_len) {
+    jstok_off_t start_quote = p->pos;
+    jstok_off_t end = jstok_scan_string_token(p, json, json_len);
+
+    if (end < 0) return end;
+    p->key_start = start_quote + 1;
+    p->key_end = end;
+    p->pos++; /* consume closing quote */
+    return 0;
+}
+#endif
+
+#if defined(JSTOK_KEY_HASHES) || defined(JSTOK_KEY_PREFIX)
+/* Hash and prefix of the key json[ks, ke), read while its bytes are still in cache */
+static JSTOK_INLINE void jstok_store_key_words(jstoktok_t* t, const char* json, jstok_off_t ks, jstok_off_t ke) {
+#ifdef JSTOK_KEY_HASHES
+    t->hash = jstok_key_hash(json + ks, (size_t)(ke - ks));
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    t->prefix = jstok_key_prefix(json + ks, (size_t)(ke - ks));
+#endif
+}
+#endif
+
+#ifdef JSTOK_FUSED_MEMBERS
+/* Hand the pending key to token i, the value just created for it */
+static void jstok_attach_key(jstok_parser* p, const char* json, jstoktok_t* toks, jstok_off_t i) {
+    if (toks) {
+#ifdef JSTOK_COMPACT_TOKENS
+        toks[i].key = (unsigned int)p->key_start;
+        toks[i].key_len = (unsigned int)(p->key_end - p->key_start) + 1u;
+#else
+        toks[i].key = p->key_start;
+        toks[i].key_end = p->key_end;
+#endif
+#if defined(JSTOK_KEY_HASHES) || defined(JSTOK_KEY_PREFIX)
+        jstok_store_key_words(&toks[i], json, p->key_start, p->key_end);
+#endif
+    } else if (p->soa && p->soa->key) {
+        p->soa->key[i] = p->key_start;
+        p->soa->key_end[i] = p->key_end;
+    }
+    (void)json;
+}
+#endif
+
+static int jstok_parse_literal(jstok_parser* p, const char* json, jstok_off_t json_len, const char* lit, int lit_len,
                                unsigned flags) {
     int i;
-    int start = p->pos;
-    int avail = json_len - start;
+    jstok_off_t start = p->pos;
+    jstok_off_t avail = json_len - start;
+    int done = 0;
+
+    if (p->part_start == start && p->part_phase == JSTOK_PART_LITERAL) done = (int)(p->part_scan - start);
+    p->part_start = -1;
 
     if (avail < lit_len) {
+        /* Remember the matched prefix, the next chunk compares only new bytes */
+        while (done < avail && json[start + done] == lit[done]) done++;
         jstok_set_error(p, JSTOK_ERROR_PART, json_len);
+        jstok_set_part(p, start, start + done, JSTOK_PART_LITERAL);
         p->pos = start; /* Rewind for resume */
         return JSTOK_ERROR_PART;
     }
 
-    if (memcmp(json + start, lit, (size_t)lit_len) != 0) {
-        for (i = 0; i < lit_len; i++) {
+#ifdef JSTOK_SWAR
+    if (avail > lit_len && jstok_word_match(json + start, lit, lit_len)) {
+        if (!jstok_is_delim(json[start + lit_len])) {
+            jstok_set_error(p, JSTOK_ERROR_INVAL, start + lit_len);
+            return JSTOK_ERROR_INVAL;
+        }
+        return lit_len;
+    }
+#endif
+    if (memcmp(json + start + done, lit + done, (size_t)(lit_len - done)) != 0) {
+        for (i = done; i < lit_len; i++) {
             if (json[start + i] != lit[i]) {
                 jstok_set_error(p, JSTOK_ERROR_INVAL, start + i);
                 return JSTOK_ERROR_INVAL;
@@ -526,6 +1918,7 @@ static int jstok_parse_literal(jstok_parser* p, const char* json, int json_len,
     if (start + lit_len >= json_len) {
         if ((flags & JSTOK_PARSE_FINAL) == 0u) {
             jstok_set_error(p, JSTOK_ERROR_PART, start + lit_len);
+            jstok_set_part(p, start, start + lit_len, JSTOK_PART_LITERAL);
             p->pos = start; /* Rewind for resume */
             return JSTOK_ERROR_PART;
         }
@@ -538,99 +1931,134 @@ static int jstok_parse_literal(jstok_parser* p, const char* json, int json_len,
     return lit_len;
 }
 
-static int jstok_parse_number_span(jstok_parser* p, const char* json, int json_len, int* out_end, unsigned flags) {
-    int i = p->pos;
+/*
+ * Each JSTOK_PART_NUM_* phase has a label below. A number cut off by a
+ * non-final chunk records its phase and continues there on the next call.
+ */
+static int jstok_parse_number_span(jstok_parser* p, const char* json, jstok_off_t json_len, jstok_off_t* out_end,
+                                   unsigned flags) {
+    jstok_off_t i = p->pos;
+    int phase = JSTOK_PART_NONE;
+    int resume = p->part_start == i ? p->part_phase : JSTOK_PART_NONE;
+
+    p->part_start = -1;
+    if (resume >= JSTOK_PART_NUM_SIGN) i = p->part_scan;
+    switch (resume) {
+        case JSTOK_PART_NUM_SIGN: goto num_sign;
+        case JSTOK_PART_NUM_ZERO: goto num_zero;
+        case JSTOK_PART_NUM_INT: goto num_int;
+        case JSTOK_PART_NUM_DOT: goto num_dot;
+        case JSTOK_PART_NUM_FRAC: goto num_frac;
+        case JSTOK_PART_NUM_E: goto num_e;
+        case JSTOK_PART_NUM_EXP_SIGN: goto num_exp_sign;
+        case JSTOK_PART_NUM_EXP: goto num_exp;
+        default: break;
+    }
+
+    if (i >= json_len) goto part;
+    if (json[i] == '-') i++;
 
-    if (i >= json_len) {
-        jstok_set_error(p, JSTOK_ERROR_PART, i);
-        return JSTOK_ERROR_PART;
+num_sign:
+    phase = JSTOK_PART_NUM_SIGN;
+    if (i >= json_len) goto part;
+    if (json[i] == '0') {
+        i++;
+        goto num_zero;
+    }
+    if (json[i] < '1' || json[i] > '9') {
+        jstok_set_error(p, JSTOK_ERROR_INVAL, i);
+        return JSTOK_ERROR_INVAL;
     }
+    i++;
 
-    if (json[i] == '-') {
+num_int:
+    phase = JSTOK_PART_NUM_INT;
+    while (i < json_len && jstok_is_digit(json[i])) {
         i++;
-        if (i >= json_len) {
-            jstok_set_error(p, JSTOK_ERROR_PART, i);
-            return JSTOK_ERROR_PART;
+#ifdef JSTOK_SWAR
+        /* Long integer runs (ids, timestamps) continue a word at a time */
+        if (i - p->pos >= 8) {
+            i = jstok_skip_digits_swar(json, json_len, i);
+            break;
         }
+#endif
     }
+    goto num_frac_mark;
 
-    if (json[i] == '0') {
-        i++;
-        /* no leading zeros in strict JSON, but allow 0.<frac> or 0e... */
-        if (i < json_len && jstok_is_digit(json[i])) {
+num_zero:
+    phase = JSTOK_PART_NUM_ZERO;
+    /* no leading zeros in strict JSON, but allow 0.<frac> or 0e... */
+    if (i < json_len && jstok_is_digit(json[i])) {
 #ifdef JSTOK_STRICT
-            jstok_set_error(p, JSTOK_ERROR_INVAL, i);
-            return JSTOK_ERROR_INVAL;
-#endif
-        }
-    } else if (json[i] >= '1' && json[i] <= '9') {
-        i++;
-        while (i < json_len && jstok_is_digit(json[i])) i++;
-    } else {
         jstok_set_error(p, JSTOK_ERROR_INVAL, i);
         return JSTOK_ERROR_INVAL;
+#endif
     }
 
-    if (i < json_len && json[i] == '.') {
-        i++;
-        if (i >= json_len) {
-            jstok_set_error(p, JSTOK_ERROR_PART, i);
-            return JSTOK_ERROR_PART;
-        }
-        if (!jstok_is_digit(json[i])) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, i);
-            return JSTOK_ERROR_INVAL;
-        }
-        while (i < json_len && jstok_is_digit(json[i])) i++;
+num_frac_mark:
+    if (i >= json_len || json[i] != '.') goto num_exp_mark;
+    i++;
+
+num_dot:
+    phase = JSTOK_PART_NUM_DOT;
+    if (i >= json_len) goto part;
+    if (!jstok_is_digit(json[i])) {
+        jstok_set_error(p, JSTOK_ERROR_INVAL, i);
+        return JSTOK_ERROR_INVAL;
     }
 
-    if (i < json_len && (json[i] == 'e' || json[i] == 'E')) {
-        i++;
-        if (i >= json_len) {
-            jstok_set_error(p, JSTOK_ERROR_PART, i);
-            return JSTOK_ERROR_PART;
-        }
-        if (json[i] == '+' || json[i] == '-') {
-            i++;
-            if (i >= json_len) {
-                jstok_set_error(p, JSTOK_ERROR_PART, i);
-                return JSTOK_ERROR_PART;
-            }
-        }
-        if (!jstok_is_digit(json[i])) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, i);
-            return JSTOK_ERROR_INVAL;
-        }
-        while (i < json_len && jstok_is_digit(json[i])) i++;
+num_frac:
+    phase = JSTOK_PART_NUM_FRAC;
+    while (i < json_len && jstok_is_digit(json[i])) i++;
+
+num_exp_mark:
+    if (i >= json_len || (json[i] != 'e' && json[i] != 'E')) goto num_end;
+    i++;
+
+num_e:
+    phase = JSTOK_PART_NUM_E;
+    if (i >= json_len) goto part;
+    if (json[i] == '+' || json[i] == '-') i++;
+
+num_exp_sign:
+    phase = JSTOK_PART_NUM_EXP_SIGN;
+    if (i >= json_len) goto part;
+    if (!jstok_is_digit(json[i])) {
+        jstok_set_error(p, JSTOK_ERROR_INVAL, i);
+        return JSTOK_ERROR_INVAL;
     }
 
+num_exp:
+    phase = JSTOK_PART_NUM_EXP;
+    while (i < json_len && jstok_is_digit(json[i])) i++;
+
+num_end:
     /* EOF finalizes a number only when caller marks this chunk as final. */
     if (i >= json_len) {
-        if ((flags & JSTOK_PARSE_FINAL) == 0u) {
-            jstok_set_error(p, JSTOK_ERROR_PART, i);
-            return JSTOK_ERROR_PART;
-        }
-        if (p->depth != 0) {
-            jstok_set_error(p, JSTOK_ERROR_PART, i);
-            return JSTOK_ERROR_PART;
-        }
+        if ((flags & JSTOK_PARSE_FINAL) == 0u || p->depth != 0) goto part;
         *out_end = i;
         return 0;
     }
 
-    if (i < json_len && !jstok_is_delim(json[i])) {
+    if (!jstok_is_delim(json[i])) {
         jstok_set_error(p, JSTOK_ERROR_INVAL, i);
         return JSTOK_ERROR_INVAL;
     }
 
     *out_end = i;
     return 0;
+
+part:
+    jstok_set_error(p, JSTOK_ERROR_PART, i);
+    if (phase != JSTOK_PART_NONE) jstok_set_part(p, p->pos, i, phase);
+    return JSTOK_ERROR_PART;
 }
 
-static int jstok_parse_primitive_token(jstok_parser* p, const char* json, int json_len, jstoktok_t* toks,
-                                       int max_tokens, int parent, unsigned flags) {
-    int start = p->pos;
-    int n, endpos;
+/* End of the literal or number at p->pos, which does not move, or an error */
+static JSTOK_INLINE jstok_off_t jstok_scan_primitive(jstok_parser* p, const char* json, jstok_off_t json_len,
+                                                     unsigned flags) {
+    jstok_off_t endpos;
+    int n;
 
     if (p->pos >= json_len) {
         jstok_set_error(p, JSTOK_ERROR_PART, p->pos);
@@ -639,38 +2067,111 @@ static int jstok_parse_primitive_token(jstok_parser* p, const char* json, int js
 
     if (json[p->pos] == 't') {
         n = jstok_parse_literal(p, json, json_len, "true", 4, flags);
-        if (n < 0) return n;
-        p->pos += n;
-        return jstok_new_token(p, toks, max_tokens, JSTOK_PRIMITIVE, start, p->pos, parent);
+        endpos = p->pos + n;
     } else if (json[p->pos] == 'f') {
         n = jstok_parse_literal(p, json, json_len, "false", 5, flags);
-        if (n < 0) return n;
-        p->pos += n;
-        return jstok_new_token(p, toks, max_tokens, JSTOK_PRIMITIVE, start, p->pos, parent);
+        endpos = p->pos + n;
     } else if (json[p->pos] == 'n') {
         n = jstok_parse_literal(p, json, json_len, "null", 4, flags);
-        if (n < 0) return n;
-        p->pos += n;
-        return jstok_new_token(p, toks, max_tokens, JSTOK_PRIMITIVE, start, p->pos, parent);
+        endpos = p->pos + n;
     } else {
         /* number */
         endpos = 0;
         n = jstok_parse_number_span(p, json, json_len, &endpos, flags);
-        if (n < 0) return n;
-        p->pos = endpos;
-        return jstok_new_token(p, toks, max_tokens, JSTOK_PRIMITIVE, start, p->pos, parent);
     }
+    if (n < 0) return n;
+    return endpos;
+}
+
+static jstok_off_t jstok_parse_primitive_token(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* toks,
+                                               jstok_off_t max_tokens, jstok_off_t parent, unsigned flags) {
+    jstok_off_t start = p->pos;
+    jstok_off_t endpos = jstok_scan_primitive(p, json, json_len, flags);
+
+    if (endpos < 0) return endpos;
+    p->pos = endpos;
+    return jstok_new_token(p, toks, max_tokens, JSTOK_PRIMITIVE, start, p->pos, parent);
+}
+
+#ifdef JSTOK_PRIMITIVE_RUNS
+/* Grow token r by n primitives that end at end, a primitive becomes a run at its second element */
+static void jstok_run_grow(jstok_parser* p, jstoktok_t* toks, jstok_off_t r, jstok_off_t n, jstok_off_t end) {
+    if (toks) {
+        toks[r].size += toks[r].type == JSTOK_PRIMITIVE ? n + 1 : n;
+        toks[r].type = JSTOK_PRIMITIVE_RUN;
+        toks[r].end = end;
+    } else if (p->soa) {
+        p->soa->size[r] += p->soa->type[r] == JSTOK_PRIMITIVE ? n + 1 : n;
+        p->soa->type[r] = (unsigned char)JSTOK_PRIMITIVE_RUN;
+        p->soa->end[r] = end;
+    }
+}
+
+/* Append the primitive at p->pos to token p->run; no new token, so no NOMEM */
+static jstok_off_t jstok_extend_run(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* toks,
+                                    unsigned flags) {
+    jstok_off_t endpos = jstok_scan_primitive(p, json, json_len, flags);
+
+    if (endpos < 0) return endpos;
+    p->pos = endpos;
+    jstok_run_grow(p, toks, p->run, 1, endpos);
+    return p->run;
+}
+
+/*
+ * After a primitive in an array, take the ", primitive" pairs that follow
+ * into its run without a trip through the transition table for each. It
+ * stops before the comma of anything else, an element the chunk cuts off
+ * included, and the parse loop goes on from there as usual.
+ */
+static void jstok_run_tail(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* toks, unsigned flags) {
+    jstok_off_t end = p->pos;
+    jstok_off_t n = 0;
+    jstok_off_t i;
+
+    for (;;) {
+#ifdef JSTOK_SIMD_INDEX
+        i = jstok_index_next(&p->ix, json, json_len, end);
+        if (i >= json_len || json[i] != ',') break;
+        i = jstok_index_next(&p->ix, json, json_len, i + 1);
+#else
+        i = jstok_skip_space(json, json_len, end);
+        if (i >= json_len || json[i] != ',') break;
+        i = jstok_skip_space(json, json_len, i + 1);
+#endif
+        if (i >= json_len || jstok_classify(json[i]) != JSTOK_CC_OTHER) break;
+        p->pos = i;
+        i = jstok_scan_primitive(p, json, json_len, flags);
+        if (i < 0) break; /* the parse loop meets the same error */
+        end = i;
+        n++;
+    }
+    p->pos = end;
+    if (n == 0) return;
+
+    jstok_run_grow(p, toks, p->run, n, end);
+#ifdef JSTOK_PACKED_FRAMES
+    i = jstok_frame_tok(jstok_top(p));
+    if (toks && i >= 0) {
+        toks[i].size += n;
+    } else if (p->soa && i >= 0) {
+        p->soa->size[i] += n;
+    }
+#else
+    jstok_top(p)->size += n;
+#endif
 }
+#endif
 
-static int jstok_start_container(jstok_parser* p, const char* json, int json_len, jstoktok_t* toks, int max_tokens,
-                                 jstoktype_t type) {
-    int parent_idx = -1;
-    int tok_idx;
+static jstok_off_t jstok_start_container(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* toks,
+                                         jstok_off_t max_tokens, jstoktype_t type) {
+    jstok_off_t parent_idx = -1;
+    jstok_off_t tok_idx;
     jstok_state_t st;
     jstok_state_t saved_parent_st = 0;
     int saved_root_done = p->root_done;
-    int saved_pos = p->pos;
-    int toknext_before = p->toknext;
+    jstok_off_t saved_pos = p->pos;
+    jstok_off_t toknext_before = p->toknext;
     jstok_frame_t* fr;
 
     (void)json;
@@ -678,15 +2179,12 @@ static int jstok_start_container(jstok_parser* p, const char* json, int json_len
 
     fr = jstok_top(p);
     if (fr) {
-        parent_idx = fr->tok;
-        saved_parent_st = fr->st;
+        parent_idx = jstok_frame_tok(fr);
+        saved_parent_st = jstok_frame_st(fr);
     }
 
     /* This container token is a value for its parent */
-    {
-        int r = jstok_accept_value(p, toks);
-        if (r < 0) return r;
-    }
+    jstok_accept_value(p, toks);
 
     tok_idx = jstok_new_token(p, toks, max_tokens, type, p->pos, -1, parent_idx);
     if (tok_idx < 0) {
@@ -701,7 +2199,7 @@ static int jstok_start_container(jstok_parser* p, const char* json, int json_len
 
     /* Push new frame, tok_idx is -1 in count-only but that is fine */
     {
-        int pushed = jstok_push(p, type, st, toks ? tok_idx : -1);
+        int pushed = jstok_push(p, st, (toks || p->soa) ? tok_idx : -1);
         if (pushed < 0) {
             p->toknext = toknext_before;
             jstok_rollback_accept_value(p, toks, fr, saved_parent_st, saved_root_done);
@@ -711,72 +2209,92 @@ static int jstok_start_container(jstok_parser* p, const char* json, int json_len
     }
 
     p->pos++; /* consume '{' or '[' */
+#ifdef JSTOK_PRIMITIVE_RUNS
+    p->run = -1;
+#endif
     return tok_idx;
 }
 
-static int jstok_end_container(jstok_parser* p, const char* json, int json_len, jstoktok_t* toks, jstoktype_t type,
-                               char closer) {
-    jstok_frame_t* fr;
-    int tok_idx;
-
-    (void)json;
-    (void)json_len;
+/* Close the top frame, the transition table has checked its type and state */
+static void jstok_end_container(jstok_parser* p, jstoktok_t* toks) {
+    jstok_frame_t* fr = jstok_top(p);
+    jstok_off_t tok = jstok_frame_tok(fr);
 
-    fr = jstok_top(p);
-    if (!fr || fr->type != type) {
-        jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-        return JSTOK_ERROR_INVAL;
+    /* end is exclusive, so end after the closer */
+    if (p->soa && tok >= 0) {
+        p->soa->end[tok] = p->pos + 1;
+#ifndef JSTOK_PACKED_FRAMES
+        p->soa->size[tok] = fr->size;
+#endif
+    } else if (toks && tok >= 0) {
+#ifdef JSTOK_COMPACT_TOKENS /* compact tokens keep no container end */
+#ifndef JSTOK_PACKED_FRAMES
+        toks[tok].info = (toks[tok].info & 3u) | (unsigned int)fr->size << 2;
+#endif
+#else
+        toks[tok].end = p->pos + 1;
+#ifndef JSTOK_PACKED_FRAMES
+        toks[tok].size = fr->size;
+#endif
+#endif
+#ifdef JSTOK_SKIP_LINKS
+        toks[tok].next = p->toknext; /* every descendant has its token by now */
+#endif
     }
 
-    /* Enforce valid closing state */
-    if (type == JSTOK_OBJECT) {
-        if (fr->st == JSTOK_ST_OBJ_KEY) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-        if (fr->st == JSTOK_ST_OBJ_COLON || fr->st == JSTOK_ST_OBJ_VALUE) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-        if (fr->st == JSTOK_ST_OBJ_KEY_OR_END || fr->st == JSTOK_ST_OBJ_COMMA_OR_END) {
-            /* ok */
-        } else {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-    } else {
-        if (fr->st == JSTOK_ST_ARR_VALUE) {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-        if (fr->st == JSTOK_ST_ARR_VALUE_OR_END || fr->st == JSTOK_ST_ARR_COMMA_OR_END) {
-            /* ok */
-        } else {
-            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-            return JSTOK_ERROR_INVAL;
-        }
-    }
+    jstok_pop(p);
+    p->pos++; /* consume '}' or ']' */
+#ifdef JSTOK_PRIMITIVE_RUNS
+    p->run = -1;
+#endif
+}
 
-    tok_idx = fr->tok;
+/*
+ * The parse loop dispatches on jstok_transitions. On GCC/Clang each action
+ * ends in a computed goto to the next one instead of looping back to a shared
+ * switch, which gives the branch predictor per-action history.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(JSTOK_NO_COMPUTED_GOTO)
+#define JSTOK_COMPUTED_GOTO 1
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#ifdef __clang__
+#pragma clang diagnostic ignored "-Wgnu-label-as-value"
+#endif
+#endif
 
-    if (toks && tok_idx >= 0) {
-        /* end is exclusive, so end after the closer */
-        toks[tok_idx].end = p->pos + 1;
-        if (toks[tok_idx].start < 0) toks[tok_idx].start = p->pos; /* defensive */
-        if (toks[tok_idx].type != type) toks[tok_idx].type = type;
-    }
+#ifdef JSTOK_SIMD_INDEX
+#define JSTOK_SKIP_SPACE() (p->pos = jstok_index_next(&p->ix, json, json_len, p->pos))
+#else
+#define JSTOK_SKIP_SPACE() (p->pos = jstok_skip_space(json, json_len, p->pos))
+#endif
 
-    /* Pop frame and consume closer */
-    jstok_pop(p);
-    if (closer != '\0') {
-        p->pos++;
-    }
-    return 0;
-}
+#ifdef JSTOK_COMPUTED_GOTO
+#define JSTOK_ACTION(name) jstok_do_##name
+#define JSTOK_NEXT()                                                               \
+    do {                                                                           \
+        JSTOK_SKIP_SPACE();                                                        \
+        if (p->pos >= json_len) goto jstok_eof;                                    \
+        goto *jstok_actions[jstok_transitions[st][jstok_classify(json[p->pos])]]; \
+    } while (0)
+#else
+#define JSTOK_ACTION(name) case JSTOK_A_##name
+#define JSTOK_NEXT() continue
+#endif
 
-JSTOK_API int jstok_parse_ex(jstok_parser* p, const char* json, int json_len, jstoktok_t* tokens, int max_tokens,
-                             unsigned flags) {
-    int r;
+/* Shared by jstok_parse_ex and jstok_parse_soa, p->soa picks the sink */
+static jstok_off_t jstok_parse_run(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* tokens,
+                                   jstok_off_t max_tokens, unsigned flags) {
+    jstok_off_t r;
+    int st;
+#ifdef JSTOK_COMPUTED_GOTO
+    /* Same order as the JSTOK_A_* actions */
+    static const void* const jstok_actions[] = {
+        &&jstok_do_INVAL,      &&jstok_do_PRIMITIVE,  &&jstok_do_STRING,       &&jstok_do_KEY,
+        &&jstok_do_OBJECT,     &&jstok_do_ARRAY,      &&jstok_do_OBJECT_END,   &&jstok_do_ARRAY_END,
+        &&jstok_do_COLON,      &&jstok_do_OBJECT_COMMA, &&jstok_do_ARRAY_COMMA,
+    };
+#endif
 
     if (!p || !json || json_len < 0) {
         if (p) jstok_set_error(p, JSTOK_ERROR_INVAL, 0);
@@ -786,142 +2304,134 @@ JSTOK_API int jstok_parse_ex(jstok_parser* p, const char* json, int json_len, js
     /* Reset error reporting for this call */
     p->error_pos = -1;
     p->error_code = 0;
+#ifdef JSTOK_SIMD_INDEX
+    p->ix.len = 0; /* json may differ from the previous call */
+#endif
 
-    while (p->pos < json_len) {
-        char c;
-        unsigned char cls;
-        jstok_frame_t* fr;
-        int parent_idx;
-
-        while (p->pos < json_len && jstok_classify(json[p->pos]) == JSTOK_CC_SPACE) {
-            p->pos++;
-        }
-        if (p->pos >= json_len) break;
-
-        c = json[p->pos];
-        cls = jstok_classify(c);
-
-        fr = jstok_top(p);
-        parent_idx = fr ? fr->tok : -1;
-
-        if (cls == JSTOK_CC_LBRACE) {
-            /* Container start also calls accept_value internally and rolls back on failure. */
-            r = jstok_start_container(p, json, json_len, tokens, max_tokens, JSTOK_OBJECT);
-            if (r < 0) return r;
-            continue;
-        }
-
-        if (cls == JSTOK_CC_LBRACKET) {
-            r = jstok_start_container(p, json, json_len, tokens, max_tokens, JSTOK_ARRAY);
-            if (r < 0) return r;
-            continue;
-        }
-
-        if (cls == JSTOK_CC_RBRACE || cls == JSTOK_CC_RBRACKET) {
-            if (cls == JSTOK_CC_RBRACE) {
-                r = jstok_end_container(p, json, json_len, tokens, JSTOK_OBJECT, '}');
-            } else {
-                r = jstok_end_container(p, json, json_len, tokens, JSTOK_ARRAY, ']');
-            }
-            if (r < 0) return r;
-            continue;
-        }
-
-        if (cls == JSTOK_CC_COLON) {
-            if (!fr || fr->type != JSTOK_OBJECT || fr->st != JSTOK_ST_OBJ_COLON) {
-                jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-                return JSTOK_ERROR_INVAL;
-            }
-            fr->st = JSTOK_ST_OBJ_VALUE;
-            p->pos++;
-            continue;
-        }
-
-        if (cls == JSTOK_CC_COMMA) {
-            if (!fr) {
-                jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-                return JSTOK_ERROR_INVAL;
-            }
-            if (fr->type == JSTOK_OBJECT) {
-                if (fr->st != JSTOK_ST_OBJ_COMMA_OR_END) {
-                    jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-                    return JSTOK_ERROR_INVAL;
-                }
-                fr->st = JSTOK_ST_OBJ_KEY;
-                p->pos++;
-                continue;
-            } else {
-                if (fr->st != JSTOK_ST_ARR_COMMA_OR_END) {
-                    jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
-                    return JSTOK_ERROR_INVAL;
-                }
-                fr->st = JSTOK_ST_ARR_VALUE;
-                p->pos++;
-                continue;
-            }
-        }
+    st = jstok_state(p); /* row of jstok_transitions, mirrors the top frame */
 
-        if (cls == JSTOK_CC_QUOTE) {
-            int tok_idx;
+#ifdef JSTOK_COMPUTED_GOTO
+    JSTOK_NEXT();
+    {
+#else
+    for (;;) {
+        JSTOK_SKIP_SPACE();
+        if (p->pos >= json_len) break;
 
-            /* If we're in an object expecting a key, treat as key */
-            if (fr && fr->type == JSTOK_OBJECT && (fr->st == JSTOK_ST_OBJ_KEY_OR_END || fr->st == JSTOK_ST_OBJ_KEY)) {
-                jstok_state_t saved_st = fr->st;
+        switch (jstok_transitions[st][jstok_classify(json[p->pos])]) {
+#endif
+        JSTOK_ACTION(INVAL):
+            jstok_set_error(p, JSTOK_ERROR_INVAL, p->pos);
+            return JSTOK_ERROR_INVAL;
 
-                tok_idx = jstok_parse_string_token(p, json, json_len, tokens, max_tokens, parent_idx);
-                if (tok_idx < 0) {
-                    if (tok_idx == JSTOK_ERROR_PART) {
-                        fr->st = saved_st; /* Rollback state (likely irrelevant as parse_string didn't change it, but
-                                              consistent) */
-                    }
-                    return tok_idx;
-                }
-                r = jstok_accept_key(p);
-                if (r < 0) return r;
-                continue;
-            }
+        JSTOK_ACTION(OBJECT):
+            /* Container start also accepts itself as a value and rolls back on failure */
+            r = jstok_start_container(p, json, json_len, tokens, max_tokens, JSTOK_OBJECT);
+            if (r < 0) return r;
+#ifdef JSTOK_FUSED_MEMBERS
+            if (st == JSTOK_ST_OBJ_VALUE) jstok_attach_key(p, json, tokens, r);
+#endif
+            st = JSTOK_ST_OBJ_KEY_OR_END;
+            JSTOK_NEXT();
 
-            /* Otherwise treat as a value */
-            {
-                jstok_state_t saved_st = fr ? fr->st : 0;
-                int saved_root_done = p->root_done;
-                int saved_pos = p->pos;
+        JSTOK_ACTION(ARRAY):
+            r = jstok_start_container(p, json, json_len, tokens, max_tokens, JSTOK_ARRAY);
+            if (r < 0) return r;
+#ifdef JSTOK_FUSED_MEMBERS
+            if (st == JSTOK_ST_OBJ_VALUE) jstok_attach_key(p, json, tokens, r);
+#endif
+            st = JSTOK_ST_ARR_VALUE_OR_END;
+            JSTOK_NEXT();
+
+        JSTOK_ACTION(OBJECT_END):
+        JSTOK_ACTION(ARRAY_END):
+            jstok_end_container(p, tokens);
+            st = jstok_state(p);
+            JSTOK_NEXT();
+
+        JSTOK_ACTION(COLON):
+            st = JSTOK_ST_OBJ_VALUE;
+            jstok_frame_set_st(&jstok_frames(p)[p->depth - 1], JSTOK_ST_OBJ_VALUE);
+            p->pos++;
+            JSTOK_NEXT();
 
-                r = jstok_accept_value(p, tokens);
-                if (r < 0) return r;
+        JSTOK_ACTION(OBJECT_COMMA):
+            st = JSTOK_ST_OBJ_KEY;
+            jstok_frame_set_st(&jstok_frames(p)[p->depth - 1], JSTOK_ST_OBJ_KEY);
+            p->pos++;
+            JSTOK_NEXT();
 
-                tok_idx = jstok_parse_string_token(p, json, json_len, tokens, max_tokens, parent_idx);
-                if (tok_idx < 0) {
-                    jstok_rollback_accept_value(p, tokens, fr, saved_st, saved_root_done);
-                    if (tok_idx == JSTOK_ERROR_PART || tok_idx == JSTOK_ERROR_NOMEM) {
-                        p->pos = saved_pos;
-                    }
-                    return tok_idx;
-                }
-            }
-            continue;
+        JSTOK_ACTION(ARRAY_COMMA):
+            st = JSTOK_ST_ARR_VALUE;
+            jstok_frame_set_st(&jstok_frames(p)[p->depth - 1], JSTOK_ST_ARR_VALUE);
+            p->pos++;
+            JSTOK_NEXT();
+
+        JSTOK_ACTION(KEY): {
+            jstok_frame_t* fr = &jstok_frames(p)[p->depth - 1];
+
+#ifdef JSTOK_FUSED_MEMBERS
+            r = jstok_parse_key(p, json, json_len);
+            if (r < 0) return r;
+#else
+            r = jstok_parse_string_token(p, json, json_len, tokens, max_tokens, jstok_frame_tok(fr));
+            if (r < 0) return r;
+#if defined(JSTOK_KEY_HASHES) || defined(JSTOK_KEY_PREFIX)
+            if (tokens) jstok_store_key_words(&tokens[r], json, JSTOK_TOK_START(&tokens[r]), p->pos - 1);
+#endif
+#endif
+            st = JSTOK_ST_OBJ_COLON;
+            jstok_frame_set_st(fr, JSTOK_ST_OBJ_COLON);
+            JSTOK_NEXT();
         }
 
-        /* Primitive value */
-        {
-            jstok_state_t saved_st = fr ? fr->st : 0;
+        JSTOK_ACTION(STRING):
+        JSTOK_ACTION(PRIMITIVE): {
+            jstok_frame_t* fr = jstok_top(p);
             int saved_root_done = p->root_done;
-            int saved_pos = p->pos;
+            jstok_off_t saved_pos = p->pos;
+            jstok_off_t parent_idx = fr ? jstok_frame_tok(fr) : -1;
 
-            r = jstok_accept_value(p, tokens);
-            if (r < 0) return r;
+            jstok_accept_value(p, tokens);
 
-            r = jstok_parse_primitive_token(p, json, json_len, tokens, max_tokens, parent_idx, flags);
+            if (json[p->pos] == '"') {
+                r = jstok_parse_string_token(p, json, json_len, tokens, max_tokens, parent_idx);
+#ifdef JSTOK_PRIMITIVE_RUNS
+            } else if (p->run >= 0) {
+                /* only set right after a primitive in this array */
+                r = jstok_extend_run(p, json, json_len, tokens, flags);
+#endif
+            } else {
+                r = jstok_parse_primitive_token(p, json, json_len, tokens, max_tokens, parent_idx, flags);
+            }
             if (r < 0) {
-                jstok_rollback_accept_value(p, tokens, fr, saved_st, saved_root_done);
+                jstok_rollback_accept_value(p, tokens, fr, (jstok_state_t)st, saved_root_done);
                 if (r == JSTOK_ERROR_PART || r == JSTOK_ERROR_NOMEM) {
                     p->pos = saved_pos;
                 }
                 return r;
             }
+#ifdef JSTOK_FUSED_MEMBERS
+            if (st == JSTOK_ST_OBJ_VALUE) jstok_attach_key(p, json, tokens, r);
+#endif
+#ifdef JSTOK_PRIMITIVE_RUNS
+            if ((st == JSTOK_ST_ARR_VALUE_OR_END || st == JSTOK_ST_ARR_VALUE) && json[saved_pos] != '"') {
+                p->run = r;
+                jstok_run_tail(p, json, json_len, tokens, flags);
+            } else {
+                p->run = -1;
+            }
+#endif
+            st = jstok_after_value[st];
+            JSTOK_NEXT();
+        }
+#ifdef JSTOK_COMPUTED_GOTO
+    }
+jstok_eof:
+#else
         }
-        continue;
     }
+#endif
 
 #ifdef JSTOK_STRICT
     /* In strict mode, require exactly one top-level value */
@@ -946,21 +2456,117 @@ JSTOK_API int jstok_parse_ex(jstok_parser* p, const char* json, int json_len, js
     return p->toknext;
 }
 
-JSTOK_API int jstok_parse(jstok_parser* p, const char* json, int json_len, jstoktok_t* tokens, int max_tokens) {
+#undef JSTOK_NEXT
+#undef JSTOK_ACTION
+#undef JSTOK_SKIP_SPACE
+#ifdef JSTOK_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+JSTOK_API jstok_off_t jstok_parse_ex(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* tokens,
+                                     jstok_off_t max_tokens, unsigned flags) {
+    jstok_off_t r;
+
+    if (p) p->soa = (const jstok_soa_t*)0;
+    r = jstok_parse_run(p, json, json_len, tokens, max_tokens, flags);
+#ifndef JSTOK_PACKED_FRAMES
+    if (r < 0 && p) jstok_store_sizes(p, tokens);
+#endif
+    return r;
+}
+
+JSTOK_API jstok_off_t jstok_parse_grow(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t** tokens,
+                                       jstok_off_t* max_tokens, jstok_grow_fn grow, void* user, unsigned flags) {
+    jstok_off_t r;
+
+    if (!p || !tokens || !max_tokens || !grow) {
+        if (p) jstok_set_error(p, JSTOK_ERROR_INVAL, 0);
+        return JSTOK_ERROR_INVAL;
+    }
+
+    /* NOMEM leaves the parser just before the token that did not fit */
+    for (;;) {
+        jstok_off_t cap = *max_tokens;
+        jstoktok_t* t;
+
+        if (*tokens) { /* a NULL array would mean count-only */
+            r = jstok_parse_ex(p, json, json_len, *tokens, *max_tokens, flags);
+            if (r != JSTOK_ERROR_NOMEM) return r;
+        }
+        t = grow(user, *tokens, &cap);
+        if (!t || cap <= *max_tokens) {
+            if (!*tokens) jstok_set_error(p, JSTOK_ERROR_NOMEM, p->pos);
+            return JSTOK_ERROR_NOMEM;
+        }
+        *tokens = t;
+        *max_tokens = cap;
+    }
+}
+
+JSTOK_API jstok_off_t jstok_parse_soa(jstok_parser* p, const char* json, jstok_off_t json_len, const jstok_soa_t* soa,
+                                      jstok_off_t max_tokens, unsigned flags) {
+    jstok_off_t r;
+
+    if (p && soa && (!soa->type || !soa->start || !soa->end || !soa->size)) {
+        jstok_set_error(p, JSTOK_ERROR_INVAL, 0);
+        return JSTOK_ERROR_INVAL;
+    }
+    if (p) p->soa = soa;
+    r = jstok_parse_run(p, json, json_len, (jstoktok_t*)0, max_tokens, flags);
+#ifndef JSTOK_PACKED_FRAMES
+    if (r < 0 && p) jstok_store_sizes(p, (jstoktok_t*)0);
+#endif
+    return r;
+}
+
+JSTOK_API jstok_off_t jstok_parse(jstok_parser* p, const char* json, jstok_off_t json_len, jstoktok_t* tokens,
+                                  jstok_off_t max_tokens) {
     return jstok_parse_ex(p, json, json_len, tokens, max_tokens, JSTOK_PARSE_FINAL);
 }
 
+JSTOK_API jstok_off_t jstok_estimate_tokens(const char* json, jstok_off_t json_len) {
+    unsigned char pad[64];
+    unsigned long long esc = 0ULL, in_str = 0ULL, prev_scalar = 0ULL;
+    jstok_off_t pos, count = 0;
+
+    if (json_len < 0 || (!json && json_len > 0)) return JSTOK_ERROR_INVAL;
+
+    for (pos = 0; pos < json_len; pos += 64) {
+        const unsigned char* s = (const unsigned char*)json + pos;
+        unsigned long long quote, str, scalar;
+        jstok_block_t b;
+
+        if (json_len - pos < 64) {
+            memset(pad, ' ', sizeof(pad));
+            memcpy(pad, s, (size_t)(json_len - pos));
+            s = pad;
+        }
+        jstok_classify64(s, &b);
+
+        /* strings carry across blocks: in_str is all ones inside one */
+        quote = b.quote & ~jstok_escaped64(b.bslash, &esc);
+        str = jstok_prefix_xor64(quote) ^ in_str;
+        in_str = 0ULL - (str >> 63);
+        scalar = ~(b.op | b.space | b.quote) & ~str;
+
+        /* opening brackets, opening quotes and first bytes of primitives */
+        count += jstok_popcount64((b.open & ~str) | (quote & str) | (scalar & ~((scalar << 1) | prev_scalar)));
+        prev_scalar = scalar >> 63;
+    }
+    return count;
+}
+
 #ifndef JSTOK_NO_HELPERS
 
 JSTOK_API jstok_span_t jstok_span(const char* json, const jstoktok_t* t) {
     jstok_span_t s;
-    if (!json || !t || t->start < 0 || t->end < t->start) {
+    if (!json || !t || JSTOK_TOK_START(t) < 0 || JSTOK_TOK_END(t) < JSTOK_TOK_START(t)) {
         s.p = (const char*)0;
         s.n = 0;
         return s;
     }
-    s.p = json + t->start;
-    s.n = (size_t)(t->end - t->start);
+    s.p = json + JSTOK_TOK_START(t);
+    s.n = (size_t)(JSTOK_TOK_END(t) - JSTOK_TOK_START(t));
     return s;
 }
 
@@ -978,102 +2584,314 @@ JSTOK_API int jstok_eq(const char* json, const jstoktok_t* t, const char* s) {
     return memcmp(sp.p, s, n) == 0;
 }
 
-/* Skip subtree without recursion using a small stack */
-JSTOK_API int jstok_skip(const jstoktok_t* toks, int count, int i) {
-    int idx;
-    int sp;
-    int rem[JSTOK_MAX_DEPTH];
-
-    if (!toks || i < 0 || i >= count) return count;
-    if (toks[i].type == JSTOK_STRING || toks[i].type == JSTOK_PRIMITIVE) return i + 1;
+/* Skip subtree in preorder: each token visited adds its children to the tokens still owed, no stack */
+#ifdef JSTOK_FUSED_MEMBERS
+#define JSTOK_MEMBER_TOKENS 1 /* the value token, which carries the key */
+#define jstok_key_start(t) JSTOK_TOK_KEY(t)
+#define jstok_key_end(t) JSTOK_TOK_KEY_END(t)
+#else
+#define JSTOK_MEMBER_TOKENS 2 /* key token, then the value */
+#define jstok_key_start(t) (JSTOK_TOK_TYPE(t) == JSTOK_STRING ? JSTOK_TOK_START(t) : -1)
+#define jstok_key_end(t) JSTOK_TOK_END(t)
+#endif
+#ifdef JSTOK_PRIMITIVE_RUNS
+#define jstok_tok_elems(t) (JSTOK_TOK_TYPE(t) == JSTOK_PRIMITIVE_RUN ? JSTOK_TOK_SIZE(t) : 1) /* values it stands for */
+#else
+#define jstok_tok_elems(t) 1
+#endif
 
-    idx = i + 1;
-    sp = 0;
+JSTOK_API jstok_off_t jstok_skip(const jstoktok_t* toks, jstok_off_t count, jstok_off_t i) {
+    jstok_off_t owed = 1;
 
-    /* immediate children count */
-    if (toks[i].type == JSTOK_ARRAY) {
-        rem[sp++] = toks[i].size;
-    } else if (toks[i].type == JSTOK_OBJECT) {
-        rem[sp++] = toks[i].size * 2;
-    } else {
-        return i + 1;
+    if (!toks || i < 0 || i >= count) return count;
+#ifdef JSTOK_SKIP_LINKS
+    /* open containers (next == -1) still walk */
+    if (toks[i].next > i) return toks[i].next < count ? toks[i].next : count;
+#endif
+    if (JSTOK_TOK_TYPE(&toks[i]) == JSTOK_STRING || JSTOK_TOK_TYPE(&toks[i]) == JSTOK_PRIMITIVE) return i + 1;
+
+    while (owed > 0) {
+        if (i >= count) return count;
+        if (JSTOK_TOK_TYPE(&toks[i]) == JSTOK_ARRAY) {
+            owed += JSTOK_TOK_SIZE(&toks[i]);
+        } else if (JSTOK_TOK_TYPE(&toks[i]) == JSTOK_OBJECT) {
+            owed += JSTOK_TOK_SIZE(&toks[i]) * JSTOK_MEMBER_TOKENS;
+        }
+        owed -= jstok_tok_elems(&toks[i]);
+        i++;
     }
+    return i;
+}
 
-    while (sp > 0) {
-        if (rem[sp - 1] == 0) {
-            sp--;
-            continue;
+#define JSTOK_SKIP_FAST_BYTES 256 /* subtrees this short are scanned, not bisected */
+
+#ifndef JSTOK_COMPACT_TOKENS
+/* First j > i with start >= end of closed container i: gallop, bisect, then scan as jstok_soa_skip */
+static jstok_off_t jstok_skip_by_end(const jstoktok_t* toks, jstok_off_t count, jstok_off_t i) {
+    jstok_off_t lo = i + 1;
+    jstok_off_t bound = toks[i].end;
+    jstok_off_t hi, step;
+
+    if (bound - toks[i].start > JSTOK_SKIP_FAST_BYTES) {
+        hi = count;
+        step = 16;
+        while (hi - lo > step) {
+            if (toks[lo + step].start >= bound) {
+                hi = lo + step;
+                break;
+            }
+            lo += step + 1;
+            step *= 2;
+        }
+        while (hi - lo > 16) {
+            jstok_off_t mid = lo + (hi - lo) / 2;
+            if (toks[mid].start < bound) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
         }
+    }
+    while (lo < count && toks[lo].start < bound) lo++;
+    return lo;
+}
+#endif
 
-        rem[sp - 1]--;
+JSTOK_API jstok_off_t jstok_skip_fast(const jstoktok_t* toks, jstok_off_t count, jstok_off_t i) {
+#if defined(JSTOK_COMPACT_TOKENS) || defined(JSTOK_SKIP_LINKS)
+    /* no container end to search for, or already one load */
+    return jstok_skip(toks, count, i);
+#else
+    if (!toks || i < 0 || i >= count) return count;
+    if (toks[i].type != JSTOK_OBJECT && toks[i].type != JSTOK_ARRAY) return i + 1;
+    if (toks[i].end < 0) return jstok_skip(toks, count, i); /* still open */
+    return jstok_skip_by_end(toks, count, i);
+#endif
+}
 
-        if (idx >= count) return count;
+/*
+ * Tokens a container's children stand for, 0 for scalars. A container still
+ * open (no end yet, PART or NOMEM) owns every token after it, counted or not,
+ * so a trailing key without its value stays inside its object. Compact tokens
+ * keep no ends and go by the size alone.
+ */
+static jstok_off_t jstok_child_tokens(const jstoktok_t* t) {
+#ifndef JSTOK_COMPACT_TOKENS
+    if ((JSTOK_TOK_TYPE(t) & (JSTOK_OBJECT | JSTOK_ARRAY)) && JSTOK_TOK_END(t) < 0) {
+#ifdef JSTOK_LARGE
+        return LLONG_MAX; /* never used up, even by primitive runs */
+#else
+        return INT_MAX;
+#endif
+    }
+#endif
+    return JSTOK_TOK_TYPE(t) == JSTOK_OBJECT  ? JSTOK_TOK_SIZE(t) * JSTOK_MEMBER_TOKENS
+           : JSTOK_TOK_TYPE(t) == JSTOK_ARRAY ? JSTOK_TOK_SIZE(t)
+                                              : 0;
+}
 
-        if (toks[idx].type == JSTOK_STRING || toks[idx].type == JSTOK_PRIMITIVE) {
-            idx++;
-            continue;
-        }
+JSTOK_API int jstok_build_parents(const jstoktok_t* toks, jstok_off_t count, jstok_off_t* parent) {
+    jstok_off_t i, j, k, n;
 
-        if (sp >= JSTOK_MAX_DEPTH) return count;
+    if (!parent || count < 0 || (!toks && count > 0)) return -1;
 
-        if (toks[idx].type == JSTOK_ARRAY) {
-            rem[sp++] = toks[idx].size;
-            idx++;
-            continue;
-        }
+    /* Backward: parent[i] first holds the index past i's subtree, as jstok_skip returns */
+    for (i = count - 1; i >= 0; i--) {
+        n = jstok_child_tokens(&toks[i]);
+        for (j = i + 1; n > 0 && j < count; j = parent[j]) n -= jstok_tok_elems(&toks[j]);
+        parent[i] = j;
+    }
 
-        if (toks[idx].type == JSTOK_OBJECT) {
-            rem[sp++] = toks[idx].size * 2;
-            idx++;
-            continue;
+    /*
+     * Forward: the top level, then each container in order, hops over its
+     * children and overwrites their slots. A slot is read only by its parent,
+     * right before that parent writes it; written slots are below their index.
+     */
+    for (j = 0; j < count; j = k) {
+        k = parent[j];
+        parent[j] = -1;
+    }
+    for (i = 0; i < count; i++) {
+        n = jstok_child_tokens(&toks[i]);
+        for (j = i + 1; n > 0 && j < count && parent[j] > j; j = k) {
+            n -= jstok_tok_elems(&toks[j]);
+            k = parent[j];
+            parent[j] = i;
         }
+    }
+    return 0;
+}
 
-        idx++;
+/* Token holding element *idx of arr_tok or -1, *idx becomes the element's position in that token */
+static jstok_off_t jstok_array_find(const jstoktok_t* toks, jstok_off_t count, jstok_off_t arr_tok, jstok_off_t* idx) {
+    jstok_off_t cur;
+
+    if (!toks || arr_tok < 0 || arr_tok >= count) return -1;
+    if (JSTOK_TOK_TYPE(&toks[arr_tok]) != JSTOK_ARRAY) return -1;
+    if (*idx < 0 || *idx >= JSTOK_TOK_SIZE(&toks[arr_tok])) return -1;
+
+    cur = arr_tok + 1;
+    while (cur < count && *idx >= jstok_tok_elems(&toks[cur])) {
+        *idx -= jstok_tok_elems(&toks[cur]);
+        cur = jstok_skip(toks, count, cur);
     }
+    return cur < count ? cur : -1;
+}
 
-    return idx;
+JSTOK_API jstok_off_t jstok_array_at(const jstoktok_t* toks, jstok_off_t count, jstok_off_t arr_tok, jstok_off_t idx) {
+    return jstok_array_find(toks, count, arr_tok, &idx);
 }
 
-JSTOK_API int jstok_array_at(const jstoktok_t* toks, int count, int arr_tok, int idx) {
-    int i;
-    int cur;
+JSTOK_API jstok_off_t jstok_array_index(const jstoktok_t* toks, jstok_off_t count, jstok_off_t arr_tok, jstok_off_t* index,
+                                        jstok_off_t cap) {
+    jstok_off_t n, size, cur;
 
-    if (!toks || arr_tok < 0 || arr_tok >= count) return -1;
-    if (toks[arr_tok].type != JSTOK_ARRAY) return -1;
-    if (idx < 0 || idx >= toks[arr_tok].size) return -1;
+    if (!toks || !index || arr_tok < 0 || arr_tok >= count) return -1;
+    if (JSTOK_TOK_TYPE(&toks[arr_tok]) != JSTOK_ARRAY) return -1;
+    size = JSTOK_TOK_SIZE(&toks[arr_tok]);
+    if (cap < size) return -1;
 
     cur = arr_tok + 1;
-    for (i = 0; i < idx; i++) {
+    for (n = 0; n < size && cur < count; n++) {
+        index[n] = cur;
+#ifdef JSTOK_PRIMITIVE_RUNS
+        if (toks[cur].type == JSTOK_PRIMITIVE_RUN) {
+            jstok_off_t e;
+
+            for (e = 1; e < toks[cur].size && n + 1 < size; e++) index[++n] = cur;
+        }
+#endif
+#ifdef JSTOK_COMPACT_TOKENS
         cur = jstok_skip(toks, count, cur);
-        if (cur >= count) return -1;
+#else
+        /* by end offset even with JSTOK_SKIP_LINKS: a chain of next loads serializes on cache misses */
+        if (toks[cur].type != JSTOK_OBJECT && toks[cur].type != JSTOK_ARRAY) {
+            cur++;
+        } else {
+            cur = toks[cur].end < 0 ? jstok_skip(toks, count, cur) : jstok_skip_by_end(toks, count, cur);
+        }
+#endif
     }
-    return cur;
+    return n;
 }
 
-JSTOK_API int jstok_object_get(const char* json, const jstoktok_t* toks, int count, int obj_tok, const char* key) {
-    int pair;
-    int cur;
-    int k;
-    int v;
+JSTOK_API jstok_off_t jstok_array_index_at(const jstok_off_t* index, jstok_off_t n, jstok_off_t idx) {
+    if (!index || idx < 0 || idx >= n) return -1;
+    return index[idx];
+}
+
+#ifdef JSTOK_PRIMITIVE_RUNS
+JSTOK_API int jstok_run_next(const char* json, const jstoktok_t* t, jstok_off_t* pos, jstoktok_t* out) {
+    jstok_off_t i, end;
+
+    if (!json || !t || !pos || !out) return 0;
+    if (t->type != JSTOK_PRIMITIVE_RUN && t->type != JSTOK_PRIMITIVE) return 0;
+
+    /* the parser validated the run, so a primitive ends at the first delimiter */
+    end = t->end;
+    i = *pos < t->start ? t->start : *pos;
+    while (i < end && jstok_is_delim(json[i])) i++;
+    if (i >= end) return 0;
+    *out = *t;
+    out->type = JSTOK_PRIMITIVE;
+    out->start = i;
+#ifdef JSTOK_SWAR_LE
+    /* ',' or a byte below '!' (whitespace) ends it */
+    while (end - i >= 8) {
+        unsigned long long w, m;
+
+        memcpy(&w, json + i, sizeof(w));
+        m = jstok_swar_has_byte(w, ',') | jstok_swar_has_less(w, 0x21u);
+        if (m) {
+            out->end = i + (jstok_ctz64(m) >> 3);
+            *pos = out->end;
+            out->size = 0;
+            return 1;
+        }
+        i += 8;
+    }
+#endif
+    while (i < end && !jstok_is_delim(json[i])) i++;
+    out->end = i;
+    out->size = 0;
+    *pos = i;
+    return 1;
+}
+
+JSTOK_API jstok_off_t jstok_array_elem(const char* json, const jstoktok_t* toks, jstok_off_t count, jstok_off_t arr_tok,
+                                       jstok_off_t idx, jstoktok_t* out) {
+    jstok_off_t cur = jstok_array_find(toks, count, arr_tok, &idx);
+    jstok_off_t i;
+
+    if (cur < 0 || !json || !out) return cur;
+    if (toks[cur].type != JSTOK_PRIMITIVE_RUN) {
+        *out = toks[cur];
+        return cur;
+    }
+
+    /* the commas between primitives are the only ones in a run, count them a word at a time */
+    for (i = toks[cur].start; toks[cur].end - i >= 8; i += 8) {
+        unsigned long long w;
+        int c;
+
+        memcpy(&w, json + i, sizeof(w));
+        /* a 1 per comma byte, summed into the top byte */
+        c = (int)(((jstok_swar_eq(w, ',') >> 7) * JSTOK_SWAR_ONES) >> 56);
+        if (c >= idx) break;
+        idx -= c;
+    }
+    for (; idx > 0; i++) idx -= json[i] == ',';
+    return jstok_run_next(json, &toks[cur], &i, out) ? cur : -1;
+}
+#endif
+
+JSTOK_API jstok_off_t jstok_object_get(const char* json, const jstoktok_t* toks, jstok_off_t count, jstok_off_t obj_tok,
+                                     const char* key) {
+    jstok_off_t pair;
+    jstok_off_t cur;
+    jstok_off_t k;
+    jstok_off_t v;
     size_t key_len;
+#ifdef JSTOK_KEY_HASHES
+    unsigned int key_hash;
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    unsigned long long key_prefix;
+#endif
 
     if (!json || !toks || !key) return -1;
     if (obj_tok < 0 || obj_tok >= count) return -1;
-    if (toks[obj_tok].type != JSTOK_OBJECT) return -1;
+    if (JSTOK_TOK_TYPE(&toks[obj_tok]) != JSTOK_OBJECT) return -1;
 
     key_len = strlen(key);
+#ifdef JSTOK_KEY_HASHES
+    key_hash = jstok_key_hash(key, key_len);
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    key_prefix = jstok_key_prefix(key, key_len);
+#endif
     cur = obj_tok + 1;
-    for (pair = 0; pair < toks[obj_tok].size; pair++) {
+    for (pair = 0; pair < JSTOK_TOK_SIZE(&toks[obj_tok]); pair++) {
         k = cur;
-        v = k + 1;
+        v = k + JSTOK_MEMBER_TOKENS - 1;
         if (v >= count) return -1;
 
-        if (toks[k].type == JSTOK_STRING) {
-            int ks = toks[k].start;
-            int ke = toks[k].end;
+#ifdef JSTOK_KEY_HASHES
+        if (toks[k].hash == key_hash) {
+#else
+        {
+#endif
+            jstok_off_t ks = jstok_key_start(&toks[k]);
+            jstok_off_t ke = jstok_key_end(&toks[k]);
             if (ks >= 0 && ke >= ks) {
                 size_t span_len = (size_t)(ke - ks);
+#ifdef JSTOK_KEY_PREFIX
+                /* the input is read only past the first 8 bytes */
+                if (span_len == key_len && toks[k].prefix == key_prefix &&
+                    (key_len <= 8 || memcmp(json + ks + 8, key + 8, key_len - 8) == 0)) {
+#else
                 if (span_len == key_len && memcmp(json + ks, key, key_len) == 0) {
+#endif
                     return v;
                 }
             }
@@ -1085,6 +2903,113 @@ JSTOK_API int jstok_object_get(const char* json, const jstoktok_t* toks, int cou
     return -1;
 }
 
+#define jstok_rotl64(x, b) (((x) << (b)) | ((x) >> (64 - (b))))
+#define JSTOK_SIPROUND()                 \
+    do {                                 \
+        v0 += v1;                        \
+        v1 = jstok_rotl64(v1, 13);       \
+        v1 ^= v0;                        \
+        v0 = jstok_rotl64(v0, 32);       \
+        v2 += v3;                        \
+        v3 = jstok_rotl64(v3, 16);       \
+        v3 ^= v2;                        \
+        v0 += v3;                        \
+        v3 = jstok_rotl64(v3, 21);       \
+        v3 ^= v0;                        \
+        v2 += v1;                        \
+        v1 = jstok_rotl64(v1, 17);       \
+        v1 ^= v2;                        \
+        v2 = jstok_rotl64(v2, 32);       \
+    } while (0)
+
+/* SipHash-1-3 of p[0..n) */
+static unsigned long long jstok_siphash13(unsigned long long k0, unsigned long long k1, const char* p, size_t n) {
+    unsigned long long v0 = k0 ^ 0x736f6d6570736575ULL;
+    unsigned long long v1 = k1 ^ 0x646f72616e646f6dULL;
+    unsigned long long v2 = k0 ^ 0x6c7967656e657261ULL;
+    unsigned long long v3 = k1 ^ 0x7465646279746573ULL;
+    unsigned long long b = (unsigned long long)n << 56;
+    unsigned long long m;
+    size_t i;
+
+    for (; n >= 8; n -= 8, p += 8) {
+#ifdef JSTOK_SWAR_LE
+        memcpy(&m, p, sizeof(m));
+#else
+        for (m = 0, i = 0; i < 8; i++) m |= (unsigned long long)(unsigned char)p[i] << (8 * i);
+#endif
+        v3 ^= m;
+        JSTOK_SIPROUND();
+        v0 ^= m;
+    }
+    for (i = 0; i < n; i++) b |= (unsigned long long)(unsigned char)p[i] << (8 * i);
+    v3 ^= b;
+    JSTOK_SIPROUND();
+    v0 ^= b;
+    v2 ^= 0xFFu;
+    JSTOK_SIPROUND();
+    JSTOK_SIPROUND();
+    JSTOK_SIPROUND();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+#undef JSTOK_SIPROUND
+
+/* Slot holding key, or the empty slot that ends its probe sequence */
+static jstok_off_t jstok_object_index_find(const jstok_object_index_t* ix, const char* key, size_t key_len) {
+    jstok_off_t h = (jstok_off_t)(jstok_siphash13(ix->k0, ix->k1, key, key_len) & (unsigned long long)ix->mask);
+
+    for (;; h = (h + 1) & ix->mask) {
+        jstok_off_t k = ix->slots[h];
+        const jstoktok_t* t;
+
+        if (k < 0) return h;
+        t = &ix->toks[k];
+        if ((size_t)(jstok_key_end(t) - jstok_key_start(t)) == key_len &&
+            memcmp(ix->json + jstok_key_start(t), key, key_len) == 0)
+            return h;
+    }
+}
+
+JSTOK_API int jstok_object_index(jstok_object_index_t* ix, const char* json, const jstoktok_t* toks, jstok_off_t count,
+                                 jstok_off_t obj_tok, jstok_off_t* slots, jstok_off_t nslots, unsigned long long seed) {
+    jstok_off_t pair, cur, size, i;
+
+    if (!ix || !json || !toks || !slots || obj_tok < 0 || obj_tok >= count) return -1;
+    if (JSTOK_TOK_TYPE(&toks[obj_tok]) != JSTOK_OBJECT) return -1;
+    size = JSTOK_TOK_SIZE(&toks[obj_tok]);
+    if (nslots <= size || (nslots & (nslots - 1)) != 0) return -1; /* one slot stays empty to end probes */
+
+    ix->json = json;
+    ix->toks = toks;
+    ix->slots = slots;
+    ix->mask = nslots - 1;
+    ix->k0 = seed;
+    ix->k1 = jstok_rotl64(seed, 32) ^ 0x9E3779B97F4A7C15ULL;
+    for (i = 0; i < nslots; i++) slots[i] = -1;
+
+    cur = obj_tok + 1;
+    for (pair = 0; pair < size && cur + JSTOK_MEMBER_TOKENS - 1 < count; pair++) {
+        if (jstok_key_start(&toks[cur]) >= 0) {
+            const char* k = json + jstok_key_start(&toks[cur]);
+            size_t n = (size_t)(jstok_key_end(&toks[cur]) - jstok_key_start(&toks[cur]));
+            jstok_off_t h = jstok_object_index_find(ix, k, n);
+
+            if (slots[h] < 0) slots[h] = cur; /* a repeated key keeps its first value, as jstok_object_get */
+        }
+        cur = jstok_skip_fast(toks, count, cur + JSTOK_MEMBER_TOKENS - 1);
+    }
+    return 0;
+}
+
+JSTOK_API jstok_off_t jstok_object_index_get(const jstok_object_index_t* ix, const char* key, size_t key_len) {
+    jstok_off_t h;
+
+    if (!ix || !ix->slots || !key) return -1;
+    h = jstok_object_index_find(ix, key, key_len);
+    return ix->slots[h] < 0 ? -1 : ix->slots[h] + JSTOK_MEMBER_TOKENS - 1;
+}
+
 JSTOK_API int jstok_atoi64(const char* json, const jstoktok_t* t, long long* out) {
     jstok_span_t sp;
     unsigned long long mag;
@@ -1093,7 +3018,7 @@ JSTOK_API int jstok_atoi64(const char* json, const jstoktok_t* t, long long* out
     int neg;
 
     if (!json || !t || !out) return -1;
-    if (t->type != JSTOK_PRIMITIVE) return -1;
+    if (JSTOK_TOK_TYPE(t) != JSTOK_PRIMITIVE) return -1;
 
     sp = jstok_span(json, t);
     if (!sp.p || sp.n == 0) return -1;
@@ -1136,7 +3061,7 @@ JSTOK_API int jstok_atoi64(const char* json, const jstoktok_t* t, long long* out
 
 JSTOK_API int jstok_atob(const char* json, const jstoktok_t* t, int* out) {
     if (!json || !t || !out) return -1;
-    if (t->type != JSTOK_PRIMITIVE) return -1;
+    if (JSTOK_TOK_TYPE(t) != JSTOK_PRIMITIVE) return -1;
     if (jstok_eq(json, t, "true")) {
         *out = 1;
         return 0;
@@ -1161,7 +3086,7 @@ JSTOK_API int jstok_unescape(const char* json, const jstoktok_t* t, char* out, s
     size_t w;
 
     if (!json || !t || !out || !out_len) return -1;
-    if (t->type != JSTOK_STRING) return -1;
+    if (JSTOK_TOK_TYPE(t) != JSTOK_STRING) return -1;
 
     sp = jstok_span(json, t);
     if (!sp.p) return -1;
@@ -1280,8 +3205,8 @@ JSTOK_API int jstok_unescape(const char* json, const jstoktok_t* t, char* out, s
     return 0;
 }
 
-JSTOK_API int jstok_path(const char* json, const jstoktok_t* toks, int count, int root, ...) {
-    int curr = root;
+JSTOK_API jstok_off_t jstok_path(const char* json, const jstoktok_t* toks, jstok_off_t count, jstok_off_t root, ...) {
+    jstok_off_t curr = root;
     va_list args;
 
     if (!json || !toks || root < 0 || root >= count) return -1;
@@ -1289,7 +3214,7 @@ JSTOK_API int jstok_path(const char* json, const jstoktok_t* toks, int count, in
     va_start(args, root);
 
     while (curr >= 0 && curr < count) {
-        jstoktype_t type = toks[curr].type;
+        jstoktype_t type = JSTOK_TOK_TYPE(&toks[curr]);
 
         if (type == JSTOK_OBJECT) {
             const char* key = va_arg(args, const char*);
@@ -1308,6 +3233,183 @@ JSTOK_API int jstok_path(const char* json, const jstoktok_t* toks, int count, in
     return curr;
 }
 
+/*
+ * SoA column scans. Tokens are in document order, so start[] ascends and a
+ * closed container's subtree is every following token that starts before its
+ * end. The type column is one byte per token, so a vector covers 16-32 tokens.
+ */
+#if defined(JSTOK_HAVE_AVX2) && !defined(JSTOK_DISPATCH_X86)
+#define JSTOK_SOA_AVX2 1
+#define JSTOK_SOA_TARGET
+#elif defined(JSTOK_HAVE_SSE2)
+#define JSTOK_SOA_SSE2 1
+#define JSTOK_SOA_TARGET JSTOK_TARGET("sse2")
+#else
+#define JSTOK_SOA_TARGET
+#endif
+
+#define JSTOK_SOA_SCAN 32 /* ranges this short are scanned instead of bisected */
+
+#ifndef JSTOK_PRIMITIVE_RUNS /* scalars are no longer one element each */
+/* First j in [lo, hi) that is an object or array, or hi */
+static JSTOK_SOA_TARGET jstok_off_t jstok_soa_next_container(const unsigned char* type, jstok_off_t lo,
+                                                             jstok_off_t hi) {
+#if defined(JSTOK_SOA_AVX2)
+    const __m256i m = _mm256_set1_epi8((char)(JSTOK_OBJECT | JSTOK_ARRAY));
+    for (; lo + 32 <= hi; lo += 32) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(type + lo)), m);
+        unsigned hit = ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        if (hit) return lo + jstok_ctz64(hit);
+    }
+#elif defined(JSTOK_SOA_SSE2)
+    const __m128i m = _mm_set1_epi8((char)(JSTOK_OBJECT | JSTOK_ARRAY));
+    for (; lo + 16 <= hi; lo += 16) {
+        __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i*)(type + lo)), m);
+        unsigned hit = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) & 0xFFFFu;
+        if (hit) return lo + jstok_ctz64(hit);
+    }
+#elif defined(JSTOK_SWAR)
+    for (; lo + 8 <= hi; lo += 8) {
+        unsigned long long w;
+        memcpy(&w, type + lo, 8);
+        /* type bits are at most 0x0F, so adding 0x7F carries into bit 7 exactly for containers */
+        w = ((w & (JSTOK_SWAR_ONES * (JSTOK_OBJECT | JSTOK_ARRAY))) + JSTOK_SWAR_ONES * 0x7Fu) & JSTOK_SWAR_HIGH;
+        if (w) {
+#ifdef JSTOK_SWAR_LE
+            return lo + jstok_ctz64(w) / 8;
+#else
+            break;
+#endif
+        }
+    }
+#endif
+    while (lo < hi && !(type[lo] & (JSTOK_OBJECT | JSTOK_ARRAY))) lo++;
+    return lo;
+}
+#endif
+
+/* First j in [lo, hi) with start[j] >= bound, or hi, scanning */
+static JSTOK_SOA_TARGET jstok_off_t jstok_soa_scan_ge(const jstok_off_t* start, jstok_off_t lo, jstok_off_t hi,
+                                                      jstok_off_t bound) {
+#if defined(JSTOK_SOA_AVX2) && !defined(JSTOK_LARGE)
+    const __m256i b = _mm256_set1_epi32(bound);
+    for (; lo + 8 <= hi; lo += 8) {
+        /* lanes still inside the subtree */
+        __m256i in = _mm256_cmpgt_epi32(b, _mm256_loadu_si256((const __m256i*)(start + lo)));
+        unsigned m = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(in));
+        if (m != 0xFFu) return lo + jstok_ctz64(~m & 0xFFu);
+    }
+#elif defined(JSTOK_SOA_SSE2) && !defined(JSTOK_LARGE)
+    const __m128i b = _mm_set1_epi32(bound);
+    for (; lo + 4 <= hi; lo += 4) {
+        __m128i in = _mm_cmpgt_epi32(b, _mm_loadu_si128((const __m128i*)(start + lo)));
+        unsigned m = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(in));
+        if (m != 0xFu) return lo + jstok_ctz64(~m & 0xFu);
+    }
+#endif
+    while (lo < hi && start[lo] < bound) lo++;
+    return lo;
+}
+
+/* First j in [lo, hi) with start[j] >= bound, or hi: gallop, bisect, then scan */
+static jstok_off_t jstok_soa_lower_bound(const jstok_off_t* start, jstok_off_t lo, jstok_off_t hi, jstok_off_t bound) {
+    jstok_off_t step = JSTOK_SOA_SCAN;
+
+    /* most subtrees are small, so probe close before bisecting the rest */
+    while (hi - lo > step) {
+        if (start[lo + step] >= bound) {
+            hi = lo + step;
+            break;
+        }
+        lo += step + 1;
+        step *= 2;
+    }
+    while (hi - lo > JSTOK_SOA_SCAN) {
+        jstok_off_t mid = lo + (hi - lo) / 2;
+        if (start[mid] < bound) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return jstok_soa_scan_ge(start, lo, hi, bound);
+}
+
+JSTOK_API jstok_off_t jstok_soa_skip(const jstok_soa_t* soa, jstok_off_t count, jstok_off_t i) {
+    if (!soa || i < 0 || i >= count) return count;
+    if (!(soa->type[i] & (JSTOK_OBJECT | JSTOK_ARRAY))) return i + 1;
+    if (soa->end[i] < 0) return count; /* still open, everything after it is inside */
+    return jstok_soa_lower_bound(soa->start, i + 1, count, soa->end[i]);
+}
+
+JSTOK_API jstok_off_t jstok_soa_array_at(const jstok_soa_t* soa, jstok_off_t count, jstok_off_t arr_tok, jstok_off_t idx) {
+    jstok_off_t cur;
+#ifndef JSTOK_PRIMITIVE_RUNS
+    jstok_off_t c;
+#endif
+
+    if (!soa || arr_tok < 0 || arr_tok >= count) return -1;
+    if (soa->type[arr_tok] != JSTOK_ARRAY) return -1;
+    if (idx < 0 || idx >= soa->size[arr_tok]) return -1;
+
+    cur = arr_tok + 1;
+#ifdef JSTOK_PRIMITIVE_RUNS
+    /* a primitive run token stands for several elements */
+    while (cur < count && idx >= (soa->type[cur] == JSTOK_PRIMITIVE_RUN ? soa->size[cur] : 1)) {
+        idx -= soa->type[cur] == JSTOK_PRIMITIVE_RUN ? soa->size[cur] : 1;
+        cur = jstok_soa_skip(soa, count, cur);
+    }
+#else
+    while (idx > 0) {
+        if (cur + idx >= count) return -1;
+        /* a run of scalars is one token per element */
+        c = jstok_soa_next_container(soa->type, cur, cur + idx);
+        idx -= c - cur;
+        cur = c;
+        if (idx == 0) break;
+        cur = jstok_soa_skip(soa, count, cur);
+        idx--;
+    }
+#endif
+    return cur < count ? cur : -1;
+}
+
+JSTOK_API jstok_off_t jstok_soa_object_get(const char* json, const jstok_soa_t* soa, jstok_off_t count,
+                                           jstok_off_t obj_tok, const char* key) {
+    jstok_off_t pair;
+    jstok_off_t cur;
+    jstok_off_t v;
+    size_t key_len;
+
+    if (!json || !soa || !key) return -1;
+    if (obj_tok < 0 || obj_tok >= count) return -1;
+    if (soa->type[obj_tok] != JSTOK_OBJECT) return -1;
+
+    key_len = strlen(key);
+    cur = obj_tok + 1;
+#ifdef JSTOK_FUSED_MEMBERS
+    if (!soa->key) return -1;
+#endif
+    for (pair = 0; pair < soa->size[obj_tok]; pair++) {
+        v = cur + JSTOK_MEMBER_TOKENS - 1;
+        if (v >= count) return -1;
+
+#ifdef JSTOK_FUSED_MEMBERS
+        if (soa->key[cur] >= 0 && (size_t)(soa->key_end[cur] - soa->key[cur]) == key_len &&
+            memcmp(json + soa->key[cur], key, key_len) == 0) {
+#else
+        if (soa->type[cur] == JSTOK_STRING && (size_t)(soa->end[cur] - soa->start[cur]) == key_len &&
+            memcmp(json + soa->start[cur], key, key_len) == 0) {
+#endif
+            return v;
+        }
+
+        cur = jstok_soa_skip(soa, count, v);
+        if (cur >= count) return -1;
+    }
+    return -1;
+}
+
 JSTOK_API jstok_sse_res jstok_sse_next(const char* buf, size_t len, size_t* pos, jstok_span_t* out) {
     if (*pos > len) *pos = len;
     size_t cur = *pos;
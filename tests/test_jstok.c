@@ -201,6 +201,154 @@ int test_nesting_depth(void) {
     return 1;
 }
 
+/* Caller frames set the depth limit per parser, helpers are not bound by JSTOK_MAX_DEPTH */
+int test_caller_frames(void) {
+    enum { DEEP = 3000 };
+    jstok_parser p;
+    jstok_frame_t small[3];
+    jstok_frame_t* frames;
+    jstoktok_t* t;
+    char* json;
+    int i, n, len;
+
+    jstok_init_frames(&p, small, 3);
+    ASSERT_EQ(jstok_parse(&p, "[[{\"a\": 1}], 2]", 15, NULL, 0), 6);
+    jstok_init_frames(&p, small, 3);
+    ASSERT_EQ(jstok_parse(&p, "[[[[1]]]]", 9, NULL, 0), JSTOK_ERROR_DEPTH);
+    ASSERT_EQ(p.error_pos, 3);
+
+    /* No frames: scalars only */
+    jstok_init_frames(&p, NULL, 8);
+    ASSERT_EQ(jstok_parse(&p, "\"x\"", 3, NULL, 0), 1);
+    jstok_init_frames(&p, NULL, 8);
+    ASSERT_EQ(jstok_parse(&p, "[]", 2, NULL, 0), JSTOK_ERROR_DEPTH);
+
+    /* jstok_init goes back to the inline frames */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, "[[[[1]]]]", 9, NULL, 0), 5);
+
+    /* Far deeper than JSTOK_MAX_DEPTH */
+    len = 2 * DEEP + 1;
+    json = (char*)malloc((size_t)len + 1);
+    frames = (jstok_frame_t*)malloc(DEEP * sizeof(*frames));
+    t = (jstoktok_t*)malloc((DEEP + 1) * sizeof(*t));
+    ASSERT(json && frames && t);
+    for (i = 0; i < DEEP; i++) {
+        json[i] = '[';
+        json[DEEP + 1 + i] = ']';
+    }
+    json[DEEP] = '7';
+    json[len] = '\0';
+
+    jstok_init_frames(&p, frames, DEEP);
+    n = jstok_parse(&p, json, len, t, DEEP + 1);
+    ASSERT_EQ(n, DEEP + 1);
+#ifndef JSTOK_NO_HELPERS
+    ASSERT_EQ(jstok_skip(t, n, 0), n);
+    ASSERT_EQ(jstok_skip(t, n, DEEP - 1), n);
+    ASSERT_EQ(jstok_skip(t, n, DEEP), n);
+    ASSERT_EQ(jstok_array_at(t, n, DEEP - 2, 0), DEEP - 1);
+#endif
+    jstok_init_frames(&p, frames, DEEP - 1);
+    ASSERT_EQ(jstok_parse(&p, json, len, t, DEEP + 1), JSTOK_ERROR_DEPTH);
+
+    free(json);
+    free(frames);
+    free(t);
+    return 1;
+}
+
+/* A parser moved mid-document (a reallocated connection table) resumes where it was */
+int test_moved_parser(void) {
+    static const char json[] = "{\"a\":[1,2]}";
+    jstok_parser *p, *q;
+    jstoktok_t t[8];
+    jstok_frame_t frames[4];
+    int r;
+
+    p = (jstok_parser*)malloc(sizeof(*p));
+    ASSERT(p != NULL);
+    jstok_init(p);
+    ASSERT_EQ(jstok_parse_ex(p, json, 6, t, 8, 0), JSTOK_ERROR_PART);
+    q = (jstok_parser*)malloc(sizeof(*q));
+    ASSERT(q != NULL);
+    memcpy(q, p, sizeof(*q));
+    free(p);
+    r = jstok_parse_ex(q, json, (int)strlen(json), t, 8, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(r, 5);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[0]), 1);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[2]), 2);
+    ASSERT_EQ(JSTOK_TOK_END(&t[0]), (int)strlen(json));
+
+    /* Caller frames stay with the caller */
+    jstok_init_frames(q, frames, 4);
+    ASSERT_EQ(jstok_parse_ex(q, json, 6, t, 8, 0), JSTOK_ERROR_PART);
+    p = (jstok_parser*)malloc(sizeof(*p));
+    ASSERT(p != NULL);
+    memcpy(p, q, sizeof(*p));
+    free(q);
+    ASSERT_EQ(jstok_parse_ex(p, json, (int)strlen(json), t, 8, JSTOK_PARSE_FINAL), 5);
+    free(p);
+    return 1;
+}
+
+#ifdef JSTOK_PACKED_FRAMES
+/* One word per level: state in the low bits, container token + 1 above */
+int test_packed_frames(void) {
+    static const char json[] = "{\"a\": [1, {\"b\"";
+    jstok_parser p;
+    jstok_frame_t frames[4];
+    jstoktok_t t[8];
+
+    ASSERT_EQ((int)sizeof(jstok_frame_t), (int)sizeof(jstok_off_t));
+
+    jstok_init_frames(&p, frames, 4);
+    ASSERT_EQ(jstok_parse_ex(&p, json, (int)strlen(json), t, 8, 0), JSTOK_ERROR_PART);
+    ASSERT_EQ(p.depth, 3);
+    ASSERT_EQ((int)(frames[0] & 15u), JSTOK_ST_OBJ_COMMA_OR_END);
+    ASSERT_EQ((int)(frames[0] >> 4), 1);
+    ASSERT_EQ((int)(frames[1] & 15u), JSTOK_ST_ARR_COMMA_OR_END);
+    ASSERT_EQ((int)(frames[1] >> 4), 3);
+    ASSERT_EQ((int)(frames[2] & 15u), JSTOK_ST_OBJ_COLON);
+    ASSERT_EQ((int)(frames[2] >> 4), 5);
+
+    /* Count-only keeps no token index */
+    jstok_init_frames(&p, frames, 4);
+    ASSERT_EQ(jstok_parse_ex(&p, json, (int)strlen(json), NULL, 0, 0), JSTOK_ERROR_PART);
+    ASSERT_EQ((int)(frames[1] >> 4), 0);
+    ASSERT(JSTOK_FRAME_TOK_MAX > 0);
+
+    /* Past the last storable token index is no depth error, seen in builds with a lowered limit */
+    if (JSTOK_FRAME_TOK_MAX < 100000) {
+        int n = (int)JSTOK_FRAME_TOK_MAX, k, i, len;
+        char* big = (char*)malloc((size_t)(2 * n + 4));
+        jstoktok_t* bt = (jstoktok_t*)malloc((size_t)(n + 2) * sizeof(*bt));
+
+        ASSERT(big && bt);
+        for (k = n - 1; k <= n; k++) {
+            /* k zeros, then an empty array at token index k + 1 */
+            big[0] = '[';
+            for (i = 0; i < k; i++) {
+                big[1 + 2 * i] = '0';
+                big[2 + 2 * i] = ',';
+            }
+            memcpy(big + 1 + 2 * k, "[]]", 3);
+            len = 2 * k + 4;
+            jstok_init(&p);
+            if (k < n) {
+                ASSERT_EQ(jstok_parse(&p, big, len, bt, n + 2), k + 2);
+            } else {
+                ASSERT_EQ(jstok_parse(&p, big, len, bt, n + 2), JSTOK_ERROR_INVAL);
+                ASSERT_EQ(p.error_pos, 1 + 2 * k);
+            }
+        }
+        free(big);
+        free(bt);
+    }
+    return 1;
+}
+#endif
+
 /* -------------------------------------------------------------------------- */
 /* 3. Syntax Validation (Strict Mode) */
 /* -------------------------------------------------------------------------- */
@@ -574,6 +722,174 @@ int test_memory_retry_after_nomen(void) {
     ASSERT(t[1].type == JSTOK_ARRAY);
     ASSERT_EQ(t[1].size, 0);
 
+    /* Key token fails allocation, the retry starts at its quote again */
+    jstok_init(&p);
+    r = jstok_parse_ex(&p, "{\"key\": 1}", 10, t, 1, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(r, JSTOK_ERROR_NOMEM);
+    ASSERT_EQ(p.pos, 1);
+    ASSERT_EQ(p.toknext, 1);
+    ASSERT_EQ(t[0].size, 0);
+
+    r = jstok_parse_ex(&p, "{\"key\": 1}", 10, t, 8, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(r, 3);
+    ASSERT_EQ(t[0].size, 1);
+    ASSERT(t[1].type == JSTOK_STRING);
+    ASSERT_EQ(t[1].start, 2);
+    ASSERT_EQ(t[1].end, 5);
+
+    return 1;
+}
+
+/* Open containers show their running size whenever a call returns mid-document */
+int test_container_sizes(void) {
+    static const char json[] = "{\"a\": [1, 2, [3]], \"b\": {\"c\": [4, 5, 6], \"d\": 7}}";
+    jstok_parser p;
+    jstoktok_t t[20];
+    char* big;
+    jstoktok_t* bt;
+    int len = (int)strlen(json);
+    int i, r;
+
+    /* Cut after "5," : the object, "b" object and [4, 5, 6] are open */
+    jstok_init(&p);
+    r = jstok_parse_ex(&p, json, 37, t, 20, 0);
+    ASSERT_EQ(r, JSTOK_ERROR_PART);
+    ASSERT_EQ(p.depth, 3);
+    ASSERT_EQ(t[0].size, 2);
+    ASSERT_EQ(t[2].size, 3);
+    ASSERT_EQ(t[5].size, 1);
+    ASSERT_EQ(t[8].size, 1);
+    ASSERT_EQ(t[10].size, 2);
+
+    r = jstok_parse_ex(&p, json, len, t, 20, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(r, 16);
+    ASSERT_EQ(t[0].size, 2);
+    ASSERT_EQ(t[8].size, 2);
+    ASSERT_EQ(t[10].size, 3);
+
+    /* Every NOMEM rollback leaves the count it found */
+    for (i = 1; i < 16; i++) {
+        jstok_init(&p);
+        r = jstok_parse(&p, json, len, t, i);
+        ASSERT_EQ(r, JSTOK_ERROR_NOMEM);
+        r = jstok_parse(&p, json, len, t, 20);
+        ASSERT_EQ(r, 16);
+        ASSERT_EQ(t[0].size, 2);
+        ASSERT_EQ(t[2].size, 3);
+        ASSERT_EQ(t[5].size, 1);
+        ASSERT_EQ(t[8].size, 2);
+        ASSERT_EQ(t[10].size, 3);
+    }
+
+    /* One wide array */
+    big = (char*)malloc(2 * 100000 + 2);
+    bt = (jstoktok_t*)malloc((100000 + 1) * sizeof(*bt));
+    ASSERT(big && bt);
+    big[0] = '[';
+    for (i = 0; i < 100000; i++) {
+        big[1 + 2 * i] = '0';
+        big[2 + 2 * i] = ',';
+    }
+    big[2 * 100000] = ']';
+    big[2 * 100000 + 1] = '\0';
+    jstok_init(&p);
+    r = jstok_parse(&p, big, 2 * 100000 + 1, bt, 100000 + 1);
+    ASSERT_EQ(r, 100000 + 1);
+    ASSERT_EQ(bt[0].size, 100000);
+    ASSERT_EQ(bt[0].end, 2 * 100000 + 1);
+    free(big);
+    free(bt);
+    return 1;
+}
+
+/* Grows by *step tokens (doubles when 0), up to *limit */
+typedef struct grow_ctx {
+    int step;
+    int limit;
+    int calls;
+} grow_ctx;
+
+static jstoktok_t* test_grow(void* user, jstoktok_t* tokens, jstok_off_t* max_tokens) {
+    grow_ctx* g = (grow_ctx*)user;
+    jstok_off_t cap = g->step ? *max_tokens + g->step : (*max_tokens ? *max_tokens * 2 : 1);
+
+    g->calls++;
+    if (cap > g->limit) return NULL;
+    *max_tokens = cap;
+    return (jstoktok_t*)realloc(tokens, (size_t)cap * sizeof(*tokens));
+}
+
+int test_parse_grow(void) {
+    static const char json[] = "{\"a\": [1, \"x\", {\"b\": null}], \"c\": {}, \"d\": [[], [true]], \"e\": \"long string\"}";
+    int len = (int)strlen(json);
+    jstok_parser p;
+    jstoktok_t want[32];
+    jstoktok_t* t;
+    jstok_off_t cap;
+    grow_ctx g;
+    int n, r, i, have, step;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, json, len, want, 32);
+    ASSERT_EQ(n, 17);
+
+    /* One token at a time hits NOMEM on every kind of token, doubling only a few times */
+    for (step = 0; step <= 1; step++) {
+        t = NULL;
+        cap = 0;
+        g.step = step;
+        g.limit = 1000;
+        g.calls = 0;
+        jstok_init(&p);
+        r = jstok_parse_grow(&p, json, len, &t, &cap, test_grow, &g, JSTOK_PARSE_FINAL);
+        ASSERT_EQ(r, n);
+        ASSERT_EQ(g.calls, step ? n : 6); /* 1, 2, 4, 8, 16, 32 */
+        for (i = 0; i < n; i++) {
+            ASSERT(t[i].type == want[i].type);
+            ASSERT_EQ(t[i].start, want[i].start);
+            ASSERT_EQ(t[i].end, want[i].end);
+            ASSERT_EQ(t[i].size, want[i].size);
+        }
+        free(t);
+    }
+
+    /* A refused grow is NOMEM, the next call continues where it stopped */
+    t = NULL;
+    cap = 0;
+    g.step = 4;
+    g.limit = 8;
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_grow(&p, json, len, &t, &cap, test_grow, &g, JSTOK_PARSE_FINAL), JSTOK_ERROR_NOMEM);
+    ASSERT_EQ(cap, 8);
+    ASSERT_EQ(p.toknext, 8);
+    g.limit = 1000;
+    ASSERT_EQ(jstok_parse_grow(&p, json, len, &t, &cap, test_grow, &g, JSTOK_PARSE_FINAL), n);
+    ASSERT_EQ(t[16].end, want[16].end);
+
+    /* Refused before the first token */
+    free(t);
+    t = NULL;
+    cap = 0;
+    g.limit = 0;
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_grow(&p, json, len, &t, &cap, test_grow, &g, JSTOK_PARSE_FINAL), JSTOK_ERROR_NOMEM);
+    ASSERT_EQ(p.error_code, JSTOK_ERROR_NOMEM);
+    ASSERT(t == NULL);
+
+    /* Chunked input */
+    g.step = 1;
+    g.limit = 1000;
+    jstok_init(&p);
+    r = JSTOK_ERROR_PART;
+    for (have = 1; have <= len && r == JSTOK_ERROR_PART; have++) {
+        r = jstok_parse_grow(&p, json, have, &t, &cap, test_grow, &g, have == len ? JSTOK_PARSE_FINAL : 0);
+    }
+    ASSERT_EQ(r, n);
+    ASSERT_EQ(cap, n);
+    for (i = 0; i < n; i++) ASSERT_EQ(t[i].end, want[i].end);
+    free(t);
+
+    ASSERT_EQ(jstok_parse_grow(&p, json, len, NULL, &cap, test_grow, &g, 0), JSTOK_ERROR_INVAL);
     return 1;
 }
 
@@ -596,6 +912,352 @@ int test_count_only_correctness(void) {
     return 1;
 }
 
+/* The structural scan matches the parser, with strings, escapes and numbers across block edges */
+int test_estimate_tokens(void) {
+    static const char body[] = "\"ab\\\\\\\"c{[,:\", 1234567890, true, {\"k\\\\\": [\"\\\\\", -2.5e3]}, \"\"]";
+    char json[256];
+    jstok_parser p;
+    int k, len, n;
+    const char* obj = "{\"a\": [1, 2], \"b\": {\"c\": true}, \"d\": null}";
+
+    ASSERT_EQ(jstok_estimate_tokens(obj, (int)strlen(obj)), 11);
+    ASSERT_EQ(jstok_estimate_tokens("  42 ", 5), 1);
+    ASSERT_EQ(jstok_estimate_tokens("[1, 2", 5), 3); /* nothing is validated */
+    ASSERT_EQ(jstok_estimate_tokens("", 0), 0);
+    ASSERT_EQ(jstok_estimate_tokens(NULL, 0), 0);
+    ASSERT_EQ(jstok_estimate_tokens(NULL, 1), JSTOK_ERROR_INVAL);
+    ASSERT_EQ(jstok_estimate_tokens("[]", -1), JSTOK_ERROR_INVAL);
+
+    for (k = 0; k < 140; k++) {
+        json[0] = '[';
+        memset(json + 1, ' ', (size_t)k);
+        memcpy(json + 1 + k, body, sizeof(body));
+        len = 1 + k + (int)strlen(body);
+
+        jstok_init(&p);
+        n = jstok_parse(&p, json, len, NULL, 0);
+        ASSERT_EQ(n, 10);
+        ASSERT_EQ(jstok_estimate_tokens(json, len), n);
+    }
+    return 1;
+}
+
+/* Columns hold the same tokens as jstoktok_t, also across NOMEM retries and chunks */
+int test_soa_tokens(void) {
+    static const char json[] = "{\"a\": [1, \"x\", {\"b\": null}], \"c\": {}, \"d\": [[], [true]]}";
+    static const char arr[] = "[1, [2, \"x\"], [[]], {}, 3]";
+    int len = (int)strlen(json);
+    jstok_parser p;
+    jstoktok_t t[32];
+    unsigned char type[32];
+    jstok_off_t start[32], end[32], size[32], parent[32];
+    jstok_soa_t soa;
+    int n, r, cap, have, i;
+
+    soa.type = type;
+    soa.start = start;
+    soa.end = end;
+    soa.size = size;
+    soa.parent = parent;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, json, len, t, 32);
+    ASSERT_EQ(n, 15);
+    jstok_init(&p);
+    r = jstok_parse_soa(&p, json, len, &soa, 32, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(r, n);
+    for (i = 0; i < n; i++) {
+        ASSERT_EQ(type[i], t[i].type);
+        ASSERT_EQ(start[i], t[i].start);
+        ASSERT_EQ(end[i], t[i].end);
+        ASSERT_EQ(size[i], t[i].size);
+#ifdef JSTOK_PARENT_LINKS
+        ASSERT_EQ(parent[i], t[i].parent);
+#endif
+    }
+    ASSERT_EQ(parent[0], -1);
+    ASSERT_EQ(parent[3], 2);
+    ASSERT_EQ(parent[6], 5);
+    ASSERT_EQ(parent[14], 13);
+
+    /* NOMEM rolls sizes back like the token array does */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, arr, (int)strlen(arr), t, 32), 9);
+    for (cap = 0; cap < 9; cap++) {
+        jstok_init(&p);
+        r = jstok_parse_soa(&p, arr, (int)strlen(arr), &soa, cap, JSTOK_PARSE_FINAL);
+        ASSERT_EQ(r, JSTOK_ERROR_NOMEM);
+        ASSERT_EQ(p.toknext, cap);
+        r = jstok_parse_soa(&p, arr, (int)strlen(arr), &soa, 32, JSTOK_PARSE_FINAL);
+        ASSERT_EQ(r, 9);
+        for (i = 0; i < 9; i++) {
+            ASSERT_EQ(type[i], t[i].type);
+            ASSERT_EQ(end[i], t[i].end);
+            ASSERT_EQ(size[i], t[i].size);
+        }
+    }
+
+    /* Byte by byte without a parent column */
+    soa.parent = NULL;
+    memset(end, 0, sizeof(end));
+    jstok_init(&p);
+    r = JSTOK_ERROR_PART;
+    for (have = 1; have <= len && r == JSTOK_ERROR_PART; have++) {
+        r = jstok_parse_soa(&p, json, have, &soa, 32, have == len ? JSTOK_PARSE_FINAL : 0);
+    }
+    ASSERT_EQ(r, n);
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, json, len, t, 32), n);
+    for (i = 0; i < n; i++) ASSERT_EQ(end[i], t[i].end);
+
+    /* Count-only and missing columns */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_soa(&p, json, len, NULL, 0, JSTOK_PARSE_FINAL), n);
+    soa.size = NULL;
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_soa(&p, json, len, &soa, 32, JSTOK_PARSE_FINAL), JSTOK_ERROR_INVAL);
+    return 1;
+}
+
+#ifndef JSTOK_NO_HELPERS
+int test_array_index(void) {
+    static const char json[] = "[1, [2, 3], {\"a\": [4]}, \"s\", []]";
+    static const jstok_off_t want[5] = {1, 2, 5, 9, 10};
+    jstok_parser p;
+    jstoktok_t t[16];
+    jstoktok_t* bt;
+    jstok_off_t index[8];
+    jstok_off_t* bi;
+    char* big;
+    int count, len, i, k, n;
+
+    jstok_init(&p);
+    count = jstok_parse(&p, json, (int)strlen(json), t, 16);
+    ASSERT_EQ(count, 11);
+    ASSERT_EQ(jstok_array_index(t, count, 0, index, 8), 5);
+    for (i = 0; i < 5; i++) {
+        ASSERT_EQ(index[i], want[i]);
+        ASSERT_EQ(jstok_array_index_at(index, 5, i), jstok_array_at(t, count, 0, i));
+    }
+    ASSERT_EQ(jstok_array_index_at(index, 5, 5), -1);
+    ASSERT_EQ(jstok_array_index_at(index, 5, -1), -1);
+    ASSERT_EQ(jstok_array_index(t, count, 2, index, 8), 2);
+    ASSERT_EQ(index[1], 4);
+    ASSERT_EQ(jstok_array_index(t, count, 10, index, 8), 0);
+
+    ASSERT_EQ(jstok_array_index(t, count, 0, index, 4), -1); /* cap below size */
+    ASSERT_EQ(jstok_array_index(t, count, 5, index, 8), -1); /* object */
+    ASSERT_EQ(jstok_array_index(t, count, 11, index, 8), -1);
+    ASSERT_EQ(jstok_array_index(t, 6, 0, index, 8), 3); /* count cuts the array */
+
+    /* Elements long enough for jstok_skip_fast to bisect */
+    big = (char*)malloc(65536);
+    bt = (jstoktok_t*)malloc(16384 * sizeof(*bt));
+    bi = (jstok_off_t*)malloc(1000 * sizeof(*bi));
+    ASSERT(big && bt && bi);
+    /* every 7th element is an 80-number array, the rest are numbers */
+    len = sprintf(big, "[");
+    for (i = 0; i < 1000; i++) {
+        len += sprintf(big + len, "%s%s%d", i ? "," : "", i % 7 ? "" : "[", i);
+        if (i % 7 == 0) {
+            for (k = 1; k < 80; k++) len += sprintf(big + len, ", %d", k);
+            big[len++] = ']';
+        }
+    }
+    len += sprintf(big + len, "]");
+    jstok_init(&p);
+    count = jstok_parse(&p, big, len, bt, 16384);
+    ASSERT(count > 1000);
+    n = jstok_array_index(bt, count, 0, bi, 1000);
+    ASSERT_EQ(n, 1000);
+    for (i = 0; i < n; i++) ASSERT_EQ(jstok_array_index_at(bi, n, i), jstok_array_at(bt, count, 0, i));
+    free(big);
+    free(bt);
+    free(bi);
+    return 1;
+}
+
+/* jstok_skip_fast agrees with jstok_skip from every token, long containers bisect */
+int test_skip_fast(void) {
+    static const char small[] = "{\"a\": [1, {\"b\": [[], {}]}, \"s\"], \"c\": {\"d\": [3, 4]}, \"e\": null}";
+    jstok_parser p;
+    jstoktok_t* t;
+    char* json;
+    int len, count, cap = 4096, i, k, r;
+
+    json = (char*)malloc(16384);
+    t = (jstoktok_t*)malloc((size_t)cap * sizeof(*t));
+    ASSERT(json && t);
+
+    /* [{"k": [0, 1, ..., 9], "s": "x"}, ...] with 150 records, then a short tail */
+    len = 0;
+    json[len++] = '[';
+    for (i = 0; i < 150; i++) {
+        len += sprintf(json + len, "%s{\"k\": [%d, 1, 2, 3, 4, 5, 6, 7, 8, 9], \"s\": \"x\"}", i ? ", " : "", i);
+    }
+    len += sprintf(json + len, ", %s]", small);
+
+    jstok_init(&p);
+    count = jstok_parse(&p, json, len, t, cap);
+    ASSERT(count > 2000);
+    for (i = -1; i <= count; i++) ASSERT_EQ(jstok_skip_fast(t, count, i), jstok_skip(t, count, i));
+    ASSERT_EQ(jstok_skip_fast(t, count, 0), count);
+
+    /* A shorter count cuts the subtree */
+    for (k = 1; k < 64; k += 7) {
+        for (i = 0; i < k; i++) ASSERT_EQ(jstok_skip_fast(t, k, i), jstok_skip(t, k, i));
+    }
+
+    /* Open containers after PART */
+    for (k = 1; k < len; k += 97) {
+        jstok_init(&p);
+        r = jstok_parse_ex(&p, json, k, t, cap, 0);
+        ASSERT_EQ(r, JSTOK_ERROR_PART);
+        for (i = 0; i < p.toknext; i++) ASSERT_EQ(jstok_skip_fast(t, p.toknext, i), jstok_skip(t, p.toknext, i));
+    }
+
+    ASSERT_EQ(jstok_skip_fast(NULL, 3, 0), 3);
+    free(json);
+    free(t);
+    return 1;
+}
+
+int test_build_parents(void) {
+    static const int want[12] = {-1, 0, 0, 2, 2, 4, 4, 0, 0, 8, 8, 10};
+#ifndef JSTOK_STRICT
+    static const char multi[] = "[1, [2]] {\"k\": {}} 3";
+#endif
+    const char* json = "{\"a\":[1,{\"b\":2}],\"c\":{\"d\":[3]}}";
+    const char* doc;
+    jstok_parser p;
+    jstoktok_t t[64];
+    jstok_off_t parent[64];
+    int count, i, len, have, r;
+
+    jstok_init(&p);
+    count = jstok_parse(&p, json, (int)strlen(json), t, 64);
+    ASSERT_EQ(count, 12);
+    ASSERT_EQ(jstok_build_parents(t, count, parent), 0);
+    for (i = 0; i < count; i++) ASSERT_EQ(parent[i], want[i]);
+
+#ifndef JSTOK_STRICT
+    /* Several top-level values */
+    jstok_init(&p);
+    count = jstok_parse(&p, multi, (int)strlen(multi), t, 64);
+    ASSERT_EQ(count, 8);
+    ASSERT_EQ(jstok_build_parents(t, count, parent), 0);
+    ASSERT_EQ(parent[0], -1);
+    ASSERT_EQ(parent[3], 2);
+    ASSERT_EQ(parent[4], -1);
+    ASSERT_EQ(parent[6], 4);
+    ASSERT_EQ(parent[7], -1);
+#endif
+
+    /* Every prefix a chunked parse leaves behind, then every NOMEM cut */
+    doc = "{\"a\": [1, {\"b\": [[], {}]}, \"s\"], \"c\": {\"d\": [3, 4]}, \"e\": null}";
+    len = (int)strlen(doc);
+    for (have = 1; have <= len + 18; have++) {
+        jstok_init(&p);
+        if (have <= len) {
+            r = jstok_parse_ex(&p, doc, have, t, 64, have == len ? JSTOK_PARSE_FINAL : 0);
+            ASSERT(r == JSTOK_ERROR_PART || r == 18);
+        } else {
+            r = jstok_parse(&p, doc, len, t, have - len);
+            ASSERT(r == JSTOK_ERROR_NOMEM || r == 18);
+        }
+        count = p.toknext;
+        ASSERT_EQ(jstok_build_parents(t, count, parent), 0);
+        for (i = 0; i < count; i++) {
+            /* the nearest earlier container still open or whose subtree holds i */
+            int c = i - 1;
+            while (c >= 0 && (t[c].type == JSTOK_STRING || t[c].type == JSTOK_PRIMITIVE ||
+                              (t[c].end >= 0 && jstok_skip(t, count, c) <= i)))
+                c--;
+            ASSERT_EQ(parent[i], c);
+#ifdef JSTOK_PARENT_LINKS
+            ASSERT_EQ(parent[i], t[i].parent);
+#endif
+        }
+    }
+
+    /* A key cut off from its value stays in its object */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, "{\"a\":1,\"b\":[1,2]}", 17, t, 4), JSTOK_ERROR_NOMEM);
+    ASSERT_EQ(jstok_build_parents(t, 4, parent), 0);
+    ASSERT_EQ(parent[3], 0);
+
+    ASSERT_EQ(jstok_build_parents(t, 0, parent), 0);
+    ASSERT_EQ(jstok_build_parents(NULL, 1, parent), -1);
+    ASSERT_EQ(jstok_build_parents(t, 1, NULL), -1);
+    return 1;
+}
+
+/* jstok_object_index agrees with jstok_object_get for every key of a wide object */
+int test_object_index(void) {
+    static const char json[] = "{\"a\": 1, \"b\": [2, {\"a\": 3}], \"a\": 4, \"\": 5, \"long key past eight\": {}}";
+    jstok_object_index_t ix;
+    jstok_parser p;
+    jstoktok_t t[32];
+    jstoktok_t* bt;
+    jstok_off_t slots[16];
+    jstok_off_t* bs;
+    char* big;
+    char key[32];
+    int count, len, i;
+
+    jstok_init(&p);
+    count = jstok_parse(&p, json, (int)strlen(json), t, 32);
+    ASSERT_EQ(count, 15);
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, 0, slots, 8, 42), 0);
+    ASSERT_EQ(jstok_object_index_get(&ix, "a", 1), 2); /* first duplicate wins */
+    ASSERT_EQ(jstok_object_index_get(&ix, "b", 1), jstok_object_get(json, t, count, 0, "b"));
+    ASSERT_EQ(jstok_object_index_get(&ix, "", 0), 12);
+    ASSERT_EQ(jstok_object_index_get(&ix, "long key past eight", 19), 14);
+    ASSERT_EQ(jstok_object_index_get(&ix, "long key past eigh", 18), -1);
+    ASSERT_EQ(jstok_object_index_get(&ix, "c", 1), -1);
+    ASSERT_EQ(jstok_object_index_get(&ix, "ab", 2), -1);
+
+    /* Another seed, same answers */
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, 0, slots, 16, 0x0123456789abcdefULL), 0);
+    ASSERT_EQ(jstok_object_index_get(&ix, "a", 1), 2);
+    ASSERT_EQ(jstok_object_index_get(&ix, "", 0), 12);
+
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, 0, slots, 4, 1), -1);  /* fewer slots than keys */
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, 0, slots, 12, 1), -1); /* not a power of two */
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, 4, slots, 8, 1), -1);  /* array */
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, count, slots, 8, 1), -1);
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, 6, slots, 2, 1), 0);
+    ASSERT_EQ(jstok_object_index_get(&ix, "a", 1), 8);
+    ASSERT_EQ(jstok_object_index(&ix, json, t, count, 14, slots, 1, 1), 0); /* empty object */
+    ASSERT_EQ(jstok_object_index_get(&ix, "a", 1), -1);
+    ASSERT_EQ(jstok_object_index_get(NULL, "a", 1), -1);
+
+    /* 500 keys in a full-ish table, every 50th repeated, values nest */
+    big = (char*)malloc(32768);
+    bt = (jstoktok_t*)malloc(4096 * sizeof(*bt));
+    bs = (jstok_off_t*)malloc(512 * sizeof(*bs));
+    ASSERT(big && bt && bs);
+    len = sprintf(big, "{");
+    for (i = 0; i < 500; i++) {
+        len += sprintf(big + len, "%s\"key%d\": %s%d%s", i ? ", " : "", i % 50 ? i : 0, i % 3 ? "" : "[", i,
+                       i % 3 ? "" : "]");
+    }
+    len += sprintf(big + len, "}");
+    jstok_init(&p);
+    count = jstok_parse(&p, big, len, bt, 4096);
+    ASSERT(count > 1000);
+    ASSERT_EQ(jstok_object_index(&ix, big, bt, count, 0, bs, 512, 7), 0);
+    for (i = 0; i < 520; i++) {
+        sprintf(key, "key%d", i);
+        ASSERT_EQ(jstok_object_index_get(&ix, key, strlen(key)), jstok_object_get(big, bt, count, 0, key));
+    }
+    free(big);
+    free(bt);
+    free(bs);
+    return 1;
+}
+#endif
+
 #ifdef JSTOK_PARENT_LINKS
 
 int test_parent_links(void) {
@@ -649,6 +1311,156 @@ int test_parent_links(void) {
 
 #endif
 
+#ifdef JSTOK_SKIP_LINKS
+
+int test_skip_links(void) {
+    jstok_parser p;
+    jstoktok_t t[20];
+    const char* json = "{\"a\":[1,{\"b\":2}],\"c\":{\"d\":[3]}}";
+    static const int next[12] = {12, 2, 7, 4, 7, 6, 7, 8, 12, 10, 12, 12};
+    int len = (int)strlen(json);
+    int count, i, r;
+
+    jstok_init(&p);
+    count = jstok_parse(&p, json, len, t, 20);
+    ASSERT_EQ(count, 12);
+    for (i = 0; i < count; i++) ASSERT_EQ(t[i].next, next[i]);
+
+    /* Containers still open at a chunk end are not linked yet */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_ex(&p, json, 24, t, 20, 0), JSTOK_ERROR_PART);
+    ASSERT_EQ(p.toknext, 9);
+    ASSERT_EQ(t[0].next, -1);
+    ASSERT_EQ(t[2].next, 7);
+    ASSERT_EQ(t[8].next, -1);
+#ifndef JSTOK_NO_HELPERS
+    ASSERT_EQ(jstok_skip(t, p.toknext, 0), p.toknext);
+    ASSERT_EQ(jstok_skip(t, p.toknext, 2), 7);
+#endif
+
+    /* NOMEM leaves links of closed containers, the retry fills the rest */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, json, len, t, 8), JSTOK_ERROR_NOMEM);
+    ASSERT_EQ(t[2].next, 7);
+    r = jstok_parse(&p, json, len, t, 20);
+    ASSERT_EQ(r, 12);
+    for (i = 0; i < count; i++) ASSERT_EQ(t[i].next, next[i]);
+    return 1;
+}
+
+#endif
+
+#ifdef JSTOK_KEY_HASHES
+
+int test_key_hashes(void) {
+    jstok_parser p;
+    jstoktok_t t[32], u[32];
+    const char* json =
+        "{\"user_profile_settings_a\": \"user_profile_settings_a\", \"user_profile_settings_b\": [1, "
+        "{\"user_profile_settings_a\": 2}], \"k\\\"q\": 3, \"\": 4}";
+    int len = (int)strlen(json);
+    int count, have, i, r;
+
+    jstok_init(&p);
+    count = jstok_parse(&p, json, len, t, 32);
+    ASSERT_EQ(count, 13);
+    ASSERT(t[1].hash != 0 && t[1].hash == t[7].hash); /* same key bytes */
+    ASSERT(t[1].hash != t[3].hash);                   /* last byte differs */
+    ASSERT_EQ(t[2].hash, 0);                          /* values carry none */
+    ASSERT_EQ(t[5].hash, 0);
+    ASSERT_EQ(t[6].hash, 0);
+
+#ifndef JSTOK_NO_HELPERS
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "user_profile_settings_b"), 4);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "user_profile_settings_c"), -1);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "k\\\"q"), 10); /* raw bytes, as in the JSON */
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, ""), 12);
+    ASSERT_EQ(jstok_path(json, t, count, 0, "user_profile_settings_b", 1, "user_profile_settings_a", NULL), 8);
+#endif
+
+    /* Chunked input and NOMEM retries hash every key exactly once it closes */
+    jstok_init(&p);
+    r = JSTOK_ERROR_PART;
+    for (have = 1; have <= len && r == JSTOK_ERROR_PART; have++) {
+        r = jstok_parse_ex(&p, json, have, u, 32, have == len ? JSTOK_PARSE_FINAL : 0);
+    }
+    ASSERT_EQ(r, count);
+    for (i = 0; i < count; i++) ASSERT_EQ(u[i].hash, t[i].hash);
+    for (i = 1; i < count; i++) {
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, json, len, u, i), JSTOK_ERROR_NOMEM);
+        ASSERT_EQ(jstok_parse(&p, json, len, u, 32), count);
+        ASSERT_EQ(u[1].hash, t[1].hash);
+        ASSERT_EQ(u[9].hash, t[9].hash);
+    }
+
+    /* Equal-length keys that differ only in the middle */
+    json = "{\"attributes.sizes.value\": 1, \"attributes.rates.value\": 2}";
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, json, (int)strlen(json), t, 32), 5);
+    ASSERT(t[1].hash != t[3].hash);
+    return 1;
+}
+
+#endif
+
+#ifdef JSTOK_KEY_PREFIX
+
+int test_key_prefix(void) {
+    jstok_parser p;
+    jstoktok_t t[32], u[32];
+    const char* json =
+        "{\"id\": \"identity\", \"exactly8\": 1, \"ninebytes\": [2, {\"id\": 3}], \"ninebytez\": 4, \"\": 5, "
+        "\"a\\nb\": 6}";
+    unsigned long long w;
+    int len = (int)strlen(json);
+    int count, have, i, r;
+
+    jstok_init(&p);
+    count = jstok_parse(&p, json, len, t, 32);
+    ASSERT_EQ(count, 17);
+    w = 0;
+    memcpy(&w, "id", 2);
+    ASSERT(t[1].prefix == w && t[9].prefix == w);
+    memcpy(&w, "exactly8", 8);
+    ASSERT(t[3].prefix == w);
+    memcpy(&w, "ninebyte", 8);
+    ASSERT(t[5].prefix == w && t[11].prefix == w);
+    ASSERT(t[2].prefix == 0); /* "identity" is a value */
+    ASSERT(t[13].prefix == 0); /* empty key */
+    ASSERT(t[6].prefix == 0);
+
+#ifndef JSTOK_NO_HELPERS
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "id"), 2);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "exactly8"), 4);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "exactly"), -1);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "ninebytes"), 6);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "ninebytez"), 12);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "ninebytey"), -1);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, ""), 14);
+    ASSERT_EQ(jstok_object_get(json, t, count, 0, "a\\nb"), 16);
+    ASSERT_EQ(jstok_path(json, t, count, 0, "ninebytes", 1, "id", NULL), 10);
+#endif
+
+    /* Chunked input and NOMEM retries store the same prefixes */
+    jstok_init(&p);
+    r = JSTOK_ERROR_PART;
+    for (have = 1; have <= len && r == JSTOK_ERROR_PART; have++) {
+        r = jstok_parse_ex(&p, json, have, u, 32, have == len ? JSTOK_PARSE_FINAL : 0);
+    }
+    ASSERT_EQ(r, count);
+    for (i = 0; i < count; i++) ASSERT(u[i].prefix == t[i].prefix);
+    for (i = 1; i < count; i++) {
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, json, len, u, i), JSTOK_ERROR_NOMEM);
+        ASSERT_EQ(jstok_parse(&p, json, len, u, 32), count);
+        ASSERT(u[5].prefix == t[5].prefix && u[15].prefix == t[15].prefix);
+    }
+    return 1;
+}
+
+#endif
+
 /* -------------------------------------------------------------------------- */
 
 /* 5. Helper Functions */
@@ -831,6 +1643,106 @@ int test_helpers_extended(void) {
 
 /* -------------------------------------------------------------------------- */
 
+/* Random nesting with long scalar runs, so column scans cross vector widths */
+static void soa_gen(char* out, int* n, int cap, unsigned* seed, int depth) {
+    int k, items;
+
+    *seed = *seed * 1103515245u + 12345u;
+    items = (int)((*seed >> 8) % (depth ? 12u : 90u));
+    if (*n + 64 >= cap || depth > 5) items = 0;
+
+    if ((*seed >> 20) & 1u) {
+        out[(*n)++] = '[';
+        for (k = 0; k < items && *n + 64 < cap; k++) {
+            if (k) out[(*n)++] = ',';
+            *seed = *seed * 1103515245u + 12345u;
+            if ((*seed >> 16) % 7u == 0) {
+                soa_gen(out, n, cap, seed, depth + 1);
+            } else {
+                *n += sprintf(out + *n, "%u", (*seed >> 16) % 1000u);
+            }
+        }
+        out[(*n)++] = ']';
+    } else {
+        out[(*n)++] = '{';
+        for (k = 0; k < items && *n + 64 < cap; k++) {
+            if (k) out[(*n)++] = ',';
+            *n += sprintf(out + *n, "\"k%d\":", k);
+            *seed = *seed * 1103515245u + 12345u;
+            if ((*seed >> 16) % 5u == 0) {
+                soa_gen(out, n, cap, seed, depth + 1);
+            } else {
+                *n += sprintf(out + *n, "\"s%u\"", (*seed >> 16) % 100u);
+            }
+        }
+        out[(*n)++] = '}';
+    }
+}
+
+/* jstok_soa_* agree with the jstoktok_t helpers on every token */
+int test_soa_helpers(void) {
+    enum { CAP = 65536, MAXT = 16384 };
+    char* json = (char*)malloc(CAP);
+    jstoktok_t* t = (jstoktok_t*)malloc(MAXT * sizeof(*t));
+    unsigned char* type = (unsigned char*)malloc(MAXT);
+    jstok_off_t* cols = (jstok_off_t*)malloc(3 * MAXT * sizeof(*cols));
+    jstok_soa_t soa;
+    jstok_parser p;
+    unsigned seed;
+    int len, n, i, k, round;
+    char key[16];
+
+    ASSERT(json && t && type && cols);
+    soa.type = type;
+    soa.start = cols;
+    soa.end = cols + MAXT;
+    soa.size = cols + 2 * MAXT;
+    soa.parent = NULL;
+
+    for (round = 0, seed = 7; round < 20; round++) {
+        len = 0;
+        soa_gen(json, &len, CAP, &seed, 0);
+        json[len] = '\0';
+
+        jstok_init(&p);
+        n = jstok_parse(&p, json, len, t, MAXT);
+        ASSERT(n > 0);
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse_soa(&p, json, len, &soa, MAXT, JSTOK_PARSE_FINAL), n);
+
+        for (i = 0; i <= n; i++) {
+            ASSERT_EQ(jstok_soa_skip(&soa, n, i), jstok_skip(t, n, i));
+            if (i < n && t[i].type == JSTOK_ARRAY) {
+                for (k = -1; k <= t[i].size; k++) {
+                    ASSERT_EQ(jstok_soa_array_at(&soa, n, i, k), jstok_array_at(t, n, i, k));
+                }
+            }
+            if (i < n && t[i].type == JSTOK_OBJECT) {
+                for (k = 0; k <= t[i].size; k++) {
+                    snprintf(key, sizeof(key), "k%d", k);
+                    ASSERT_EQ(jstok_soa_object_get(json, &soa, n, i, key), jstok_object_get(json, t, n, i, key));
+                }
+            }
+        }
+    }
+
+    /* An unclosed container holds every token after it */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_soa(&p, "[1, [2, 3], {\"a\": [4", 20, &soa, MAXT, 0), JSTOK_ERROR_PART);
+    n = p.toknext;
+    ASSERT_EQ(n, 8);
+    ASSERT_EQ(jstok_soa_skip(&soa, n, 0), n);
+    ASSERT_EQ(jstok_soa_skip(&soa, n, 2), 5);
+    ASSERT_EQ(jstok_soa_skip(&soa, n, 5), n);
+    ASSERT_EQ(jstok_soa_array_at(&soa, n, 0, 2), 5);
+
+    free(json);
+    free(t);
+    free(type);
+    free(cols);
+    return 1;
+}
+
 int test_sse_extended(void) {
     jstok_span_t span;
 
@@ -1028,6 +1940,201 @@ int test_async_chunked(void) {
     return 1;
 }
 
+/* -------------------------------------------------------------------------- */
+/* 9. Long Inputs / Block Boundaries */
+/* -------------------------------------------------------------------------- */
+
+int test_block_boundaries(void) {
+    jstok_parser p;
+    jstoktok_t t[16];
+    char buf[512];
+    int pad;
+
+    /* Shift a small document across every offset of a 64-byte block */
+    for (pad = 0; pad < 130; pad++) {
+        int n = 0;
+        int count;
+
+        memset(buf, ' ', (size_t)pad);
+        n = pad;
+        n += sprintf(buf + n, "{\"k\\\"ey\":[1,  \"%s\\\\\",true],\n%*s\"b\":\"x\\u0041\"}", "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnop", pad % 70, "");
+
+        jstok_init(&p);
+        count = jstok_parse(&p, buf, n, t, 16);
+        ASSERT_EQ(count, 8);
+        ASSERT(t[0].type == JSTOK_OBJECT);
+        ASSERT_EQ(t[0].start, pad);
+        ASSERT_EQ(t[0].end, n);
+        ASSERT_EQ(t[0].size, 2);
+        ASSERT_EQ(t[1].start, pad + 2);
+        ASSERT_EQ(t[1].end, pad + 7);
+        ASSERT(t[2].type == JSTOK_ARRAY);
+        ASSERT_EQ(t[2].size, 3);
+        ASSERT(t[4].type == JSTOK_STRING);
+        ASSERT_EQ(t[4].end - t[4].start, 64);
+        ASSERT(t[5].type == JSTOK_PRIMITIVE);
+        ASSERT(t[7].type == JSTOK_STRING);
+        ASSERT_EQ(t[7].end, n - 2);
+
+        /* Control byte deep inside a long string is still rejected */
+        buf[t[4].start + 40] = '\n';
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, buf, n, t, 16), JSTOK_ERROR_INVAL);
+        ASSERT_EQ(p.error_pos, pad + 55);
+    }
+
+    return 1;
+}
+
+int test_string_scan_positions(void) {
+    jstok_parser p;
+    jstoktok_t t[4];
+    char buf[160];
+    int i;
+
+    /* Every lane of a vector/word kernel must see the stop byte */
+    for (i = 0; i < 100; i++) {
+        memset(buf, 'a', sizeof(buf));
+        buf[0] = '[';
+        buf[1] = '"';
+        buf[102] = '"';
+        buf[103] = ']';
+
+        buf[2 + i] = '\t';
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, buf, 104, t, 4), JSTOK_ERROR_INVAL);
+        ASSERT_EQ(p.error_pos, 2 + i);
+
+        if (i < 99) {
+            buf[2 + i] = '\\';
+            buf[3 + i] = 'n';
+            jstok_init(&p);
+            ASSERT_EQ(jstok_parse(&p, buf, 104, t, 4), 2);
+            ASSERT_EQ(t[1].start, 2);
+            ASSERT_EQ(t[1].end, 102);
+        }
+
+        buf[2 + i] = '"';
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, buf, 104, t, 4), JSTOK_ERROR_INVAL);
+        ASSERT_EQ(p.error_pos, 3 + i);
+    }
+
+    return 1;
+}
+
+int test_whitespace_runs(void) {
+    static const char ws[] = " \t\n\r";
+    jstok_parser p;
+    jstoktok_t t[4];
+    char buf[512];
+    int len, i;
+
+    for (len = 0; len < 100; len++) {
+        int n = 0;
+
+        buf[n++] = '[';
+        for (i = 0; i < len; i++) buf[n++] = ws[(i * 7 + len) % 4];
+        buf[n++] = '1';
+        for (i = 0; i < len; i++) buf[n++] = ws[i % 4];
+        buf[n++] = ']';
+        for (i = 0; i < len; i++) buf[n++] = ' ';
+
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, buf, n, t, 4), 2);
+        ASSERT_EQ(t[1].start, 1 + len);
+        ASSERT_EQ(t[1].end, 2 + len);
+        ASSERT_EQ(t[0].end, 3 + 2 * len);
+
+        /* A stray byte ends the run wherever it sits */
+        buf[1 + len + 1 + len / 2] = 'x';
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, buf, n, t, 4), JSTOK_ERROR_INVAL);
+        ASSERT_EQ(p.error_pos, len ? 2 + len + len / 2 : 2);
+    }
+
+    return 1;
+}
+
+int test_number_digit_runs(void) {
+    jstok_parser p;
+    jstoktok_t t[4];
+    char buf[256];
+    int len, i, n;
+
+    for (len = 1; len < 40; len++) {
+        /* [1ddd.ddde+ddd] with every part len digits long */
+        n = 0;
+        buf[n++] = '[';
+        for (i = 0; i < len; i++) buf[n++] = (char)('1' + (i % 9));
+        buf[n++] = '.';
+        for (i = 0; i < len; i++) buf[n++] = (char)('0' + (i % 10));
+        buf[n++] = 'e';
+        buf[n++] = '+';
+        for (i = 0; i < len; i++) buf[n++] = (char)('9' - (i % 10));
+        buf[n++] = ']';
+
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, buf, n, t, 4), 2);
+        ASSERT_EQ(t[1].start, 1);
+        ASSERT_EQ(t[1].end, n - 1);
+
+        /* A non-digit inside the run is reported where it sits */
+        buf[1 + len / 2] = ':';
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, buf, n, t, 4), JSTOK_ERROR_INVAL);
+        ASSERT_EQ(p.error_pos, len / 2 ? 1 + len / 2 : 1);
+    }
+
+    return 1;
+}
+
+int test_literal_words(void) {
+    static const char* lits[] = {"true", "false", "null"};
+    static const char after[] = ",]x";
+    jstok_parser p;
+    jstoktok_t t[4];
+    char buf[64];
+    int l, a, pad, n, r;
+
+    for (l = 0; l < 3; l++) {
+        int ll = (int)strlen(lits[l]);
+        for (a = 0; a < 3; a++) {
+            for (pad = 0; pad < 10; pad++) {
+                n = 0;
+                buf[n++] = '[';
+                memcpy(buf + n, lits[l], (size_t)ll);
+                n += ll;
+                buf[n++] = after[a];
+                if (after[a] != ']') {
+                    buf[n++] = '0';
+                    buf[n++] = ']';
+                }
+                memset(buf + n, ' ', (size_t)pad);
+                n += pad;
+
+                jstok_init(&p);
+                r = jstok_parse(&p, buf, n, t, 4);
+                if (after[a] == 'x') {
+                    ASSERT_EQ(r, JSTOK_ERROR_INVAL);
+                    ASSERT_EQ(p.error_pos, 1 + ll);
+                } else {
+                    ASSERT(r > 0);
+                    ASSERT_EQ(t[1].end, 1 + ll);
+                }
+
+                /* Last letter wrong */
+                buf[ll] = 'Z';
+                jstok_init(&p);
+                ASSERT_EQ(jstok_parse(&p, buf, n, t, 4), JSTOK_ERROR_INVAL);
+                ASSERT_EQ(p.error_pos, ll);
+            }
+        }
+    }
+
+    return 1;
+}
+
 int main(void) {
     printf("Starting jstok comprehensive tests...\n");
 
@@ -1040,6 +2147,11 @@ int main(void) {
     TEST(nesting_structure);
 
     TEST(nesting_depth);
+    TEST(caller_frames);
+    TEST(moved_parser);
+#ifdef JSTOK_PACKED_FRAMES
+    TEST(packed_frames);
+#endif
 
     TEST(syntax_errors);
 
@@ -1052,17 +2164,35 @@ int main(void) {
 
     TEST(memory_bounds);
     TEST(memory_retry_after_nomen);
+    TEST(container_sizes);
+    TEST(parse_grow);
     TEST(count_only_correctness);
+    TEST(estimate_tokens);
+    TEST(soa_tokens);
 
 #ifdef JSTOK_PARENT_LINKS
     TEST(parent_links);
 #endif
+#ifdef JSTOK_SKIP_LINKS
+    TEST(skip_links);
+#endif
+#ifdef JSTOK_KEY_HASHES
+    TEST(key_hashes);
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    TEST(key_prefix);
+#endif
 
 #ifndef JSTOK_NO_HELPERS
     TEST(helpers_atoi64_bounds);
     TEST(helpers_edge_cases);
     TEST(helpers_extended);
     TEST(unescape_unicode);
+    TEST(soa_helpers);
+    TEST(build_parents);
+    TEST(skip_fast);
+    TEST(array_index);
+    TEST(object_index);
 
     TEST(sse_extended);
 #endif
@@ -1071,6 +2201,12 @@ int main(void) {
 
     TEST(async_chunked);
 
+    TEST(block_boundaries);
+    TEST(string_scan_positions);
+    TEST(whitespace_runs);
+    TEST(number_digit_runs);
+    TEST(literal_words);
+
     printf("\nTests run: %d, Failed: %d\n", tests_run, tests_failed);
 
     return tests_failed > 0 ? 1 : 0;
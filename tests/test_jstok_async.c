@@ -234,6 +234,154 @@ int test_async_final_flag_root_primitive(void) {
     return 1;
 }
 
+int test_async_string_resume(void) {
+    const char* json = "[\"ab\\\"c\\\\d\\/e\\bf\\fg\\nh\\ri\\tj\\u00e9k\\uD83D\\uDE00l\",\"x\"]";
+    int len = (int)strlen(json);
+    int split;
+
+    /* Two chunks, cut at every position */
+    for (split = 1; split < len; split++) {
+        jstok_parser p;
+        jstoktok_t tokens[8];
+        int r;
+
+        jstok_init(&p);
+        r = jstok_parse_ex(&p, json, split, tokens, 8, 0);
+        ASSERT(r == JSTOK_ERROR_PART);
+        r = jstok_parse_ex(&p, json, len, tokens, 8, JSTOK_PARSE_FINAL);
+        ASSERT_EQ(r, 3);
+        ASSERT(tokens[1].type == JSTOK_STRING);
+        ASSERT_EQ(tokens[1].start, 2);
+        ASSERT_EQ(tokens[1].end, len - 6);
+        ASSERT_EQ(tokens[2].start, len - 3);
+    }
+
+    /* Byte by byte; pos stays at the opening quote while the string is cut */
+    {
+        jstok_parser p;
+        jstoktok_t tokens[8];
+        int r;
+        int have;
+
+        jstok_init(&p);
+        for (have = 2; have <= len - 6; have++) {
+            r = jstok_parse_ex(&p, json, have, tokens, 8, 0);
+            ASSERT(r == JSTOK_ERROR_PART);
+            ASSERT_EQ(p.pos, 1);
+        }
+        r = jstok_parse_ex(&p, json, len, tokens, 8, JSTOK_PARSE_FINAL);
+        ASSERT_EQ(r, 3);
+    }
+
+    return 1;
+}
+
+int test_async_string_resume_errors(void) {
+    const char* bad_escape = "\"abc\\x\"";
+    const char* bad_hex = "\"abc\\u12G4\"";
+    const char* ctrl = "\"abc\ndef\"";
+    jstok_parser p;
+    jstoktok_t tokens[4];
+    int r;
+
+    /* Cut right after the backslash */
+    jstok_init(&p);
+    r = jstok_parse_ex(&p, bad_escape, 5, tokens, 4, 0);
+    ASSERT(r == JSTOK_ERROR_PART);
+    r = jstok_parse_ex(&p, bad_escape, (int)strlen(bad_escape), tokens, 4, JSTOK_PARSE_FINAL);
+    ASSERT(r == JSTOK_ERROR_INVAL);
+    ASSERT_EQ(p.error_pos, 5);
+
+    /* Cut inside the \u escape */
+    jstok_init(&p);
+    r = jstok_parse_ex(&p, bad_hex, 8, tokens, 4, 0);
+    ASSERT(r == JSTOK_ERROR_PART);
+    r = jstok_parse_ex(&p, bad_hex, (int)strlen(bad_hex), tokens, 4, JSTOK_PARSE_FINAL);
+    ASSERT(r == JSTOK_ERROR_INVAL);
+    ASSERT_EQ(p.error_pos, 8);
+
+    /* Control character in the new bytes */
+    jstok_init(&p);
+    r = jstok_parse_ex(&p, ctrl, 4, tokens, 4, 0);
+    ASSERT(r == JSTOK_ERROR_PART);
+    r = jstok_parse_ex(&p, ctrl, (int)strlen(ctrl), tokens, 4, JSTOK_PARSE_FINAL);
+    ASSERT(r == JSTOK_ERROR_INVAL);
+    ASSERT_EQ(p.error_pos, 4);
+
+    return 1;
+}
+
+int test_async_primitive_resume(void) {
+    const char* json = "[-12345678901234.5678e+12,0,-0.5E-3,true,false,null,7]";
+    int len = (int)strlen(json);
+    int split, have;
+
+    for (split = 1; split < len; split++) {
+        jstok_parser p;
+        jstoktok_t tokens[16];
+        int r;
+
+        jstok_init(&p);
+        r = jstok_parse_ex(&p, json, split, tokens, 16, 0);
+        ASSERT(r == JSTOK_ERROR_PART);
+        r = jstok_parse_ex(&p, json, len, tokens, 16, JSTOK_PARSE_FINAL);
+        ASSERT_EQ(r, 8);
+        ASSERT_EQ(tokens[1].start, 1);
+        ASSERT_EQ(tokens[1].end, 25);
+        ASSERT_EQ(tokens[3].start, 28);
+        ASSERT_EQ(tokens[3].end, 35);
+        ASSERT_EQ(tokens[5].end, 46);
+        ASSERT_EQ(tokens[7].start, len - 2);
+    }
+
+    /* Byte by byte, pos stays at the start of the cut primitive */
+    {
+        jstok_parser p;
+        jstoktok_t tokens[16];
+        int r;
+
+        jstok_init(&p);
+        for (have = 2; have <= 25; have++) {
+            r = jstok_parse_ex(&p, json, have, tokens, 16, 0);
+            ASSERT(r == JSTOK_ERROR_PART);
+            ASSERT_EQ(p.pos, 1);
+        }
+        for (have = 26; have <= len; have++) {
+            r = jstok_parse_ex(&p, json, have, tokens, 16, have == len ? JSTOK_PARSE_FINAL : 0);
+        }
+        ASSERT_EQ(r, 8);
+    }
+
+    return 1;
+}
+
+int test_async_primitive_resume_errors(void) {
+    static const struct {
+        const char* json;
+        int cut;
+        int error_pos;
+    } cases[] = {
+        {"[1.x]", 3, 3}, {"[1e+x]", 4, 4}, {"[1ex]", 3, 3}, {"[-x]", 2, 2},
+        {"[12a]", 3, 3}, {"[trux]", 4, 4}, {"[fals]", 5, 5}, {"[nulll]", 5, 5},
+    };
+    size_t k;
+
+    for (k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        jstok_parser p;
+        jstoktok_t tokens[4];
+        int r;
+
+        jstok_init(&p);
+        r = jstok_parse_ex(&p, cases[k].json, cases[k].cut, tokens, 4, 0);
+        ASSERT(r == JSTOK_ERROR_PART);
+        r = jstok_parse_ex(&p, cases[k].json, (int)strlen(cases[k].json), tokens, 4, JSTOK_PARSE_FINAL);
+        ASSERT(r == JSTOK_ERROR_INVAL);
+        ASSERT_EQ(p.error_pos, cases[k].error_pos);
+    }
+
+    return 1;
+}
+
 /* -------------------------------------------------------------------------- */
 /* SSE Async Tests */
 /* -------------------------------------------------------------------------- */
@@ -299,6 +447,10 @@ int main(void) {
     TEST(async_split_tokens);
     TEST(async_split_tokens_deep);
     TEST(async_final_flag_root_primitive);
+    TEST(async_string_resume);
+    TEST(async_string_resume_errors);
+    TEST(async_primitive_resume);
+    TEST(async_primitive_resume_errors);
     TEST(sse_fragmentation);
 
     printf("\nTests run: %d, Failed: %d\n", tests_run, tests_failed);
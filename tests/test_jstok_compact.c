@@ -0,0 +1,197 @@
+// test_jstok_compact.c: JSTOK_COMPACT_TOKENS layout, read through JSTOK_TOK_*()
+#include <stdio.h>
+#include <string.h>
+
+#ifndef JSTOK_COMPACT_TOKENS
+#define JSTOK_COMPACT_TOKENS
+#endif
+
+#include "jstok.h"
+
+/* Minimal test framework */
+int tests_run = 0;
+int tests_failed = 0;
+
+#define TEST(name)                       \
+    do {                                 \
+        printf("Running %s... ", #name); \
+        if (test_##name()) {             \
+            printf("PASS\n");            \
+        } else {                         \
+            printf("FAIL\n");            \
+            tests_failed++;              \
+        }                                \
+        tests_run++;                     \
+    } while (0)
+
+#define ASSERT(cond)                                                                \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            printf("\nAssertion failed at %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            return 0;                                                               \
+        }                                                                           \
+    } while (0)
+
+#define ASSERT_EQ(val, expected)                                                                  \
+    do {                                                                                          \
+        int v = (val);                                                                            \
+        int e = (expected);                                                                       \
+        if (v != e) {                                                                             \
+            printf("\nAssertion failed at %s:%d: %s (got %d, expected %d)\n", __FILE__, __LINE__, \
+                   #val " == " #expected, v, e);                                                  \
+            return 0;                                                                             \
+        }                                                                                         \
+    } while (0)
+
+static const char doc[] = "{\"id\": 42, \"name\": \"a\\nb\", \"tags\": [\"x\", [], {}], \"ok\": true, \"n\": -1.5e3}";
+
+int test_compact_layout(void) {
+#if !defined(JSTOK_PARENT_LINKS) && !defined(JSTOK_SKIP_LINKS) && !defined(JSTOK_KEY_HASHES) && \
+    !defined(JSTOK_KEY_PREFIX)
+    ASSERT_EQ((int)sizeof(jstoktok_t), 8);
+#endif
+    return 1;
+}
+
+int test_compact_tokens(void) {
+    jstok_parser p;
+    jstoktok_t t[32];
+    int n;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, (int)strlen(doc), t, 32);
+    ASSERT_EQ(n, 14);
+
+    ASSERT(JSTOK_TOK_TYPE(&t[0]) == JSTOK_OBJECT);
+    ASSERT_EQ(JSTOK_TOK_START(&t[0]), 0);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[0]), 5);
+    ASSERT_EQ(JSTOK_TOK_END(&t[0]), -1); /* container ends are not stored */
+    ASSERT(jstok_span(doc, &t[0]).p == NULL);
+
+    ASSERT(JSTOK_TOK_TYPE(&t[1]) == JSTOK_STRING);
+    ASSERT_EQ(JSTOK_TOK_START(&t[1]), 2);
+    ASSERT_EQ(JSTOK_TOK_END(&t[1]), 4);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[1]), 0);
+    ASSERT(JSTOK_TOK_TYPE(&t[2]) == JSTOK_PRIMITIVE);
+    ASSERT(jstok_eq(doc, &t[2], "42"));
+
+    ASSERT(JSTOK_TOK_TYPE(&t[6]) == JSTOK_ARRAY);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[6]), 3);
+    ASSERT(JSTOK_TOK_TYPE(&t[8]) == JSTOK_ARRAY);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[8]), 0);
+    ASSERT(JSTOK_TOK_TYPE(&t[9]) == JSTOK_OBJECT);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[9]), 0);
+
+#ifdef JSTOK_PARENT_LINKS
+    ASSERT_EQ(t[0].parent, -1);
+    ASSERT_EQ(t[7].parent, 6);
+    ASSERT_EQ(t[10].parent, 0);
+#endif
+#ifdef JSTOK_KEY_HASHES
+    ASSERT(t[1].hash != t[3].hash);
+    ASSERT_EQ(t[2].hash, 0);
+    ASSERT_EQ(t[7].hash, 0); /* array element, not a key */
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    ASSERT(t[1].prefix != 0 && memcmp(&t[1].prefix, "id\0\0\0\0\0\0", 8) == 0);
+    ASSERT(t[7].prefix == 0);
+    ASSERT_EQ(jstok_object_get(doc, t, n, 0, "tags"), 6);
+#endif
+
+    /* Count-only agrees */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, doc, (int)strlen(doc), NULL, 0), 14);
+    return 1;
+}
+
+int test_compact_helpers(void) {
+    jstok_parser p;
+    jstoktok_t t[32];
+    jstok_object_index_t ix;
+    jstok_off_t parent[32], idx[4], slots[8];
+    char buf[16];
+    size_t len;
+    long long v;
+    int b, n, i;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, (int)strlen(doc), t, 32);
+    ASSERT_EQ(n, 14);
+
+    ASSERT_EQ(jstok_skip(t, n, 0), n);
+    ASSERT_EQ(jstok_skip(t, n, 6), 10);
+    ASSERT_EQ(jstok_skip_fast(t, n, 6), 10);
+    ASSERT_EQ(jstok_array_at(t, n, 6, 2), 9);
+    ASSERT_EQ(jstok_array_at(t, n, 6, 3), -1);
+    ASSERT_EQ(jstok_array_index(t, n, 6, idx, 4), 3);
+    ASSERT_EQ(jstok_array_index_at(idx, 3, 2), 9);
+
+    i = jstok_object_get(doc, t, n, 0, "id");
+    ASSERT(i >= 0 && jstok_atoi64(doc, &t[i], &v) == 0 && v == 42);
+    i = jstok_object_get(doc, t, n, 0, "name");
+    ASSERT(i >= 0 && jstok_unescape(doc, &t[i], buf, sizeof(buf), &len) == 0);
+    ASSERT(len == 3 && memcmp(buf, "a\nb", 3) == 0);
+    i = jstok_object_get(doc, t, n, 0, "ok");
+    ASSERT(i >= 0 && jstok_atob(doc, &t[i], &b) == 0 && b == 1);
+    i = jstok_path(doc, t, n, 0, "tags", 0, NULL);
+    ASSERT(i >= 0 && jstok_eq(doc, &t[i], "x"));
+    ASSERT_EQ(jstok_object_get(doc, t, n, 0, "missing"), -1);
+    ASSERT(jstok_eq(doc, &t[jstok_object_get(doc, t, n, 0, "n")], "-1.5e3"));
+    ASSERT_EQ(jstok_object_index(&ix, doc, t, n, 0, slots, 8, 3), 0);
+    ASSERT_EQ(jstok_object_index_get(&ix, "tags", 4), 6);
+    ASSERT_EQ(jstok_object_index_get(&ix, "n", 1), 13);
+    ASSERT_EQ(jstok_object_index_get(&ix, "missing", 7), -1);
+
+    /* Parents from sizes alone, compact containers have no end */
+    ASSERT_EQ(jstok_build_parents(t, n, parent), 0);
+    ASSERT_EQ(parent[0], -1);
+    ASSERT_EQ(parent[7], 6);
+    ASSERT_EQ(parent[9], 6);
+    ASSERT_EQ(parent[10], 0);
+    return 1;
+}
+
+/* Sizes survive NOMEM rollback and chunked input */
+int test_compact_retry(void) {
+    static const char arr[] = "[1, [2, \"x\"], [[]], 3]";
+    jstok_parser p;
+    jstoktok_t t[32];
+    int len = (int)strlen(doc);
+    int cap, have, r;
+
+    for (cap = 1; cap < 8; cap++) {
+        jstok_init(&p);
+        r = jstok_parse(&p, arr, (int)strlen(arr), t, cap);
+        ASSERT(r == JSTOK_ERROR_NOMEM);
+        r = jstok_parse(&p, arr, (int)strlen(arr), t, 32);
+        ASSERT_EQ(r, 8);
+        ASSERT_EQ(JSTOK_TOK_SIZE(&t[0]), 4);
+        ASSERT_EQ(JSTOK_TOK_SIZE(&t[2]), 2);
+        ASSERT_EQ(JSTOK_TOK_SIZE(&t[5]), 1);
+        ASSERT_EQ(JSTOK_TOK_SIZE(&t[6]), 0);
+    }
+
+    jstok_init(&p);
+    r = JSTOK_ERROR_PART;
+    for (have = 1; have <= len && r == JSTOK_ERROR_PART; have++) {
+        r = jstok_parse_ex(&p, doc, have, t, 32, have == len ? JSTOK_PARSE_FINAL : 0);
+    }
+    ASSERT_EQ(r, 14);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[0]), 5);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[6]), 3);
+    ASSERT_EQ(JSTOK_TOK_END(&t[13]), len - 1);
+    return 1;
+}
+
+int main(void) {
+    printf("Starting jstok compact token tests...\n");
+
+    TEST(compact_layout);
+    TEST(compact_tokens);
+    TEST(compact_helpers);
+    TEST(compact_retry);
+
+    printf("\nTests run: %d, Failed: %d\n", tests_run, tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,120 @@
+// test_jstok_dispatch.c
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "jstok.h"
+
+#define MAX_TOKS 512
+
+typedef struct {
+    int rc;
+    int pos;
+    int error_pos;
+    jstoktok_t toks[MAX_TOKS];
+} result_t;
+
+static void parse(const char* json, int len, result_t* r) {
+    jstok_parser p;
+
+    memset(r, 0, sizeof(*r));
+    jstok_init(&p);
+    r->rc = jstok_parse(&p, json, len, r->toks, MAX_TOKS);
+    r->pos = p.pos;
+    r->error_pos = p.error_pos;
+}
+
+static void expect_same(const char* json, int len) {
+    static result_t want, got;
+    int isa;
+
+    jstok_set_isa(JSTOK_ISA_SCALAR);
+    parse(json, len, &want);
+
+    for (isa = JSTOK_ISA_SSE2; isa <= JSTOK_ISA_AVX512; isa++) {
+        jstok_isa_t bound = jstok_set_isa((jstok_isa_t)isa);
+        assert(bound <= (jstok_isa_t)isa);
+        assert(jstok_get_isa() == bound);
+
+        parse(json, len, &got);
+        assert(got.rc == want.rc);
+        assert(got.pos == want.pos);
+        assert(got.error_pos == want.error_pos);
+        if (want.rc > 0) assert(memcmp(got.toks, want.toks, sizeof(jstoktok_t) * (size_t)want.rc) == 0);
+    }
+}
+
+/* Stop bytes and whitespace runs at every offset across all vector widths */
+static void test_string_bodies(void) {
+    static const char stops[] = {'"', '\\', '\n', '\t', 0x01, 0x1F};
+    char buf[256];
+    int n, s;
+
+    for (n = 0; n < 200; n++) {
+        for (s = 0; s < (int)sizeof(stops); s++) {
+            int len = 0;
+
+            buf[len++] = '"';
+            memset(buf + len, 'a', (size_t)n);
+            len += n;
+            buf[len++] = stops[s];
+            if (stops[s] == '\\') buf[len++] = 'n';
+            buf[len++] = '"';
+            expect_same(buf, len);
+            expect_same(buf, len - 1); /* truncated */
+        }
+    }
+}
+
+static void test_whitespace_runs(void) {
+    static const char ws[] = {' ', '\t', '\n', '\r'};
+    char buf[512];
+    int n, w;
+
+    for (n = 0; n < 200; n++) {
+        for (w = 0; w < (int)sizeof(ws); w++) {
+            int len = 0;
+
+            buf[len++] = '[';
+            buf[len++] = '1';
+            buf[len++] = ',';
+            memset(buf + len, ws[w], (size_t)n);
+            len += n;
+            buf[len++] = '2';
+            memset(buf + len, ws[w], (size_t)n);
+            len += n;
+            buf[len++] = ']';
+            expect_same(buf, len);
+            expect_same(buf, len - 1);
+        }
+    }
+}
+
+static void test_documents(void) {
+    static const char* docs[] = {
+        "{\"a\": [1, 2.5, -3e4, true, false, null], \"b\": {\"c\": \"d\\\"e\"}}",
+        "{\n    \"key with spaces\": \"value \\u00e9 \\\\ \\/\",\n    \"nested\": [[[], {}], [{\"x\": 1}]]\n}",
+        "[\"unterminated",
+        "{\"a\" 1}",
+        "[1, 2,, 3]",
+        "\"\\\\\\\\\\\\\\\"\"",
+        "[\"\x01\"]",
+    };
+    int i;
+
+    for (i = 0; i < (int)(sizeof(docs) / sizeof(docs[0])); i++) {
+        expect_same(docs[i], (int)strlen(docs[i]));
+    }
+}
+
+int main(void) {
+    jstok_isa_t start = jstok_get_isa();
+
+    test_string_bodies();
+    test_whitespace_runs();
+    test_documents();
+
+    assert(jstok_set_isa(start) == start);
+    fprintf(stderr, "ok: dispatch tests passed (startup isa %d)\n", (int)start);
+    return 0;
+}
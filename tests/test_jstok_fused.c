@@ -0,0 +1,255 @@
+// test_jstok_fused.c: JSTOK_FUSED_MEMBERS, object members as one token carrying the key
+#include <stdio.h>
+#include <string.h>
+
+#ifndef JSTOK_FUSED_MEMBERS
+#define JSTOK_FUSED_MEMBERS
+#endif
+
+#include "jstok.h"
+
+/* Minimal test framework */
+int tests_run = 0;
+int tests_failed = 0;
+
+#define TEST(name)                       \
+    do {                                 \
+        printf("Running %s... ", #name); \
+        if (test_##name()) {             \
+            printf("PASS\n");            \
+        } else {                         \
+            printf("FAIL\n");            \
+            tests_failed++;              \
+        }                                \
+        tests_run++;                     \
+    } while (0)
+
+#define ASSERT(cond)                                                                \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            printf("\nAssertion failed at %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            return 0;                                                               \
+        }                                                                           \
+    } while (0)
+
+#define ASSERT_EQ(val, expected)                                                                  \
+    do {                                                                                          \
+        int v = (val);                                                                            \
+        int e = (expected);                                                                       \
+        if (v != e) {                                                                             \
+            printf("\nAssertion failed at %s:%d: %s (got %d, expected %d)\n", __FILE__, __LINE__, \
+                   #val " == " #expected, v, e);                                                  \
+            return 0;                                                                             \
+        }                                                                                         \
+    } while (0)
+
+static const char doc[] = "{\"id\": 42, \"name\": \"a\\nb\", \"tags\": [\"x\", [], {}], \"ok\": true, \"n\": -1.5e3}";
+
+/* key of token i equals s */
+static int key_is(const jstoktok_t* t, const char* s) {
+    jstok_off_t ks = JSTOK_TOK_KEY(t);
+    size_t n = strlen(s);
+
+    return ks >= 0 && (size_t)(JSTOK_TOK_KEY_END(t) - ks) == n && memcmp(doc + ks, s, n) == 0;
+}
+
+/* every field of two token arrays */
+static int same_tokens(const jstoktok_t* a, const jstoktok_t* b, int n) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (JSTOK_TOK_TYPE(&a[i]) != JSTOK_TOK_TYPE(&b[i]) || JSTOK_TOK_START(&a[i]) != JSTOK_TOK_START(&b[i]) ||
+            JSTOK_TOK_END(&a[i]) != JSTOK_TOK_END(&b[i]) || JSTOK_TOK_SIZE(&a[i]) != JSTOK_TOK_SIZE(&b[i]) ||
+            JSTOK_TOK_KEY(&a[i]) != JSTOK_TOK_KEY(&b[i]) || JSTOK_TOK_KEY_END(&a[i]) != JSTOK_TOK_KEY_END(&b[i]))
+            return 0;
+#ifdef JSTOK_PARENT_LINKS
+        if (a[i].parent != b[i].parent) return 0;
+#endif
+#ifdef JSTOK_KEY_HASHES
+        if (a[i].hash != b[i].hash) return 0;
+#endif
+#ifdef JSTOK_KEY_PREFIX
+        if (a[i].prefix != b[i].prefix) return 0;
+#endif
+    }
+    return 1;
+}
+
+int test_fused_tokens(void) {
+    jstok_parser p;
+    jstoktok_t t[32];
+    int n;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, (int)strlen(doc), t, 32);
+    ASSERT_EQ(n, 9); /* 14 with key tokens */
+
+    ASSERT(JSTOK_TOK_TYPE(&t[0]) == JSTOK_OBJECT);
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[0]), 5);
+    ASSERT_EQ(JSTOK_TOK_KEY(&t[0]), -1);
+
+    ASSERT(JSTOK_TOK_TYPE(&t[1]) == JSTOK_PRIMITIVE && jstok_eq(doc, &t[1], "42"));
+    ASSERT(key_is(&t[1], "id"));
+    ASSERT_EQ(JSTOK_TOK_KEY(&t[1]), 2);
+    ASSERT_EQ(JSTOK_TOK_KEY_END(&t[1]), 4);
+    ASSERT(JSTOK_TOK_TYPE(&t[2]) == JSTOK_STRING && key_is(&t[2], "name"));
+    ASSERT(JSTOK_TOK_TYPE(&t[3]) == JSTOK_ARRAY && key_is(&t[3], "tags"));
+    ASSERT_EQ(JSTOK_TOK_SIZE(&t[3]), 3);
+
+    /* array elements are no members */
+    ASSERT(jstok_eq(doc, &t[4], "x"));
+    ASSERT_EQ(JSTOK_TOK_KEY(&t[4]), -1);
+    ASSERT_EQ(JSTOK_TOK_KEY_END(&t[4]), -1);
+    ASSERT(JSTOK_TOK_TYPE(&t[6]) == JSTOK_OBJECT && JSTOK_TOK_KEY(&t[6]) == -1);
+
+    ASSERT(key_is(&t[7], "ok"));
+    ASSERT(key_is(&t[8], "n") && jstok_eq(doc, &t[8], "-1.5e3"));
+
+#ifdef JSTOK_PARENT_LINKS
+    ASSERT_EQ(t[0].parent, -1);
+    ASSERT_EQ(t[2].parent, 0);
+    ASSERT_EQ(t[5].parent, 3);
+    ASSERT_EQ(t[8].parent, 0);
+#endif
+#ifdef JSTOK_KEY_HASHES
+    ASSERT(t[1].hash != t[7].hash);
+    ASSERT_EQ(t[4].hash, 0);
+#endif
+#ifdef JSTOK_KEY_PREFIX
+    ASSERT(memcmp(&t[3].prefix, "tags\0\0\0\0", 8) == 0);
+    ASSERT(t[4].prefix == 0);
+#endif
+
+    /* Count-only agrees */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, doc, (int)strlen(doc), NULL, 0), 9);
+    ASSERT_EQ(jstok_estimate_tokens(doc, (int)strlen(doc)), 14); /* keys still counted */
+    return 1;
+}
+
+/* NOMEM at any point and byte-by-byte input leave the keys on the right tokens */
+int test_fused_retry(void) {
+    jstok_parser p;
+    jstoktok_t want[32], t[32];
+    int len = (int)strlen(doc);
+    int cap, have, n, r;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, len, want, 32);
+    ASSERT_EQ(n, 9);
+
+    for (cap = 1; cap < n; cap++) {
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, doc, len, t, cap), JSTOK_ERROR_NOMEM);
+        ASSERT_EQ(jstok_parse(&p, doc, len, t, 32), n);
+        ASSERT(same_tokens(t, want, n));
+    }
+
+    jstok_init(&p);
+    r = JSTOK_ERROR_PART;
+    for (have = 1; have <= len && r == JSTOK_ERROR_PART; have++) {
+        r = jstok_parse_ex(&p, doc, have, t, 32, have == len ? JSTOK_PARSE_FINAL : 0);
+    }
+    ASSERT_EQ(r, n);
+    ASSERT(same_tokens(t, want, n));
+    return 1;
+}
+
+int test_fused_helpers(void) {
+    static const char nested[] = "{\"a\": {\"b\": [1, {\"c\": null}], \"e\": {}}, \"d\": \"e\", \"a\": 0}";
+    jstok_object_index_t ix;
+    jstok_parser p;
+    jstoktok_t t[32];
+    jstok_off_t parent[32], idx[4], slots[8];
+    long long v;
+    int n, i;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, (int)strlen(doc), t, 32);
+    ASSERT_EQ(n, 9);
+
+    ASSERT_EQ(jstok_skip(t, n, 0), n);
+    ASSERT_EQ(jstok_skip(t, n, 3), 7);
+    ASSERT_EQ(jstok_skip_fast(t, n, 3), 7);
+    ASSERT_EQ(jstok_skip(t, n, 1), 2);
+    ASSERT_EQ(jstok_array_at(t, n, 3, 2), 6);
+    ASSERT_EQ(jstok_array_index(t, n, 3, idx, 4), 3);
+    ASSERT_EQ(jstok_array_index_at(idx, 3, 1), 5);
+
+    i = jstok_object_get(doc, t, n, 0, "id");
+    ASSERT(i == 1 && jstok_atoi64(doc, &t[i], &v) == 0 && v == 42);
+    ASSERT_EQ(jstok_object_get(doc, t, n, 0, "ok"), 7);
+    ASSERT_EQ(jstok_object_get(doc, t, n, 0, "n"), 8);
+    ASSERT_EQ(jstok_object_get(doc, t, n, 0, "x"), -1); /* a string value, not a key */
+    ASSERT_EQ(jstok_object_get(doc, t, n, 0, "missing"), -1);
+    ASSERT_EQ(jstok_path(doc, t, n, 0, "tags", 0, NULL), 4);
+
+    ASSERT_EQ(jstok_object_index(&ix, doc, t, n, 0, slots, 8, 5), 0);
+    ASSERT_EQ(jstok_object_index_get(&ix, "tags", 4), 3);
+    ASSERT_EQ(jstok_object_index_get(&ix, "n", 1), 8);
+    ASSERT_EQ(jstok_object_index_get(&ix, "x", 1), -1);
+
+    ASSERT_EQ(jstok_build_parents(t, n, parent), 0);
+    ASSERT_EQ(parent[0], -1);
+    ASSERT_EQ(parent[3], 0);
+    ASSERT_EQ(parent[6], 3);
+    ASSERT_EQ(parent[7], 0);
+
+    /* Nested members, a repeated key resolves to the first */
+    jstok_init(&p);
+    n = jstok_parse(&p, nested, (int)strlen(nested), t, 32);
+    ASSERT_EQ(n, 9);
+    ASSERT_EQ(jstok_object_get(nested, t, n, 0, "a"), 1);
+    ASSERT_EQ(jstok_object_get(nested, t, n, 0, "d"), 7);
+    ASSERT_EQ(jstok_object_get(nested, t, n, 1, "e"), 6);
+    i = jstok_path(nested, t, n, 0, "a", "b", 1, "c", NULL);
+    ASSERT(i == 5 && jstok_eq(nested, &t[i], "null"));
+    ASSERT_EQ(jstok_skip(t, n, 1), 7);
+    ASSERT_EQ(jstok_build_parents(t, n, parent), 0);
+    ASSERT_EQ(parent[5], 4);
+    ASSERT_EQ(parent[6], 1);
+    ASSERT_EQ(parent[8], 0);
+    return 1;
+}
+
+int test_fused_soa(void) {
+    unsigned char type[16];
+    jstok_off_t start[16], end[16], size[16], key[16], key_end[16];
+    jstok_soa_t soa = {type, start, end, size, NULL, key, key_end};
+    jstok_parser p;
+    jstoktok_t t[16];
+    int n, i;
+
+    jstok_init(&p);
+    n = jstok_parse_soa(&p, doc, (int)strlen(doc), &soa, 16, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(n, 9);
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, doc, (int)strlen(doc), t, 16), n);
+    for (i = 0; i < n; i++) {
+        ASSERT_EQ(key[i], JSTOK_TOK_KEY(&t[i]));
+        ASSERT_EQ(key_end[i], JSTOK_TOK_KEY_END(&t[i]));
+    }
+    ASSERT_EQ(jstok_soa_object_get(doc, &soa, n, 0, "ok"), 7);
+    ASSERT_EQ(jstok_soa_object_get(doc, &soa, n, 0, "x"), -1);
+    ASSERT_EQ(jstok_soa_skip(&soa, n, 3), 7);
+
+    /* keys are not kept without their columns */
+    soa.key = soa.key_end = NULL;
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_soa(&p, doc, (int)strlen(doc), &soa, 16, JSTOK_PARSE_FINAL), n);
+    ASSERT_EQ(jstok_soa_object_get(doc, &soa, n, 0, "ok"), -1);
+    return 1;
+}
+
+int main(void) {
+    printf("Starting jstok fused member tests...\n");
+
+    TEST(fused_tokens);
+    TEST(fused_retry);
+    TEST(fused_helpers);
+    TEST(fused_soa);
+
+    printf("\nTests run: %d, Failed: %d\n", tests_run, tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * JSTOK_LARGE: documents past the 2^31 byte boundary.
+ *
+ * A document is a sparse file whose first and last chunks hold the JSON
+ * around the interesting part. The hole in between is overlaid with
+ * repeated mappings of one small filler file, so >2 GiB of input costs
+ * a few MiB of disk and memory. POSIX, 64-bit only.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#ifndef JSTOK_LARGE
+#define JSTOK_LARGE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "jstok.h"
+
+/* Minimal test framework */
+int tests_run = 0;
+int tests_failed = 0;
+
+#define TEST(name)                       \
+    do {                                 \
+        printf("Running %s... ", #name); \
+        fflush(stdout);                  \
+        if (test_##name()) {             \
+            printf("PASS\n");            \
+        } else {                         \
+            printf("FAIL\n");            \
+            tests_failed++;              \
+        }                                \
+        tests_run++;                     \
+    } while (0)
+
+#define ASSERT(cond)                                                                \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            printf("\nAssertion failed at %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            return 0;                                                               \
+        }                                                                           \
+    } while (0)
+
+#define ASSERT_EQ(val, expected)                                                                      \
+    do {                                                                                              \
+        long long got = (val);                                                                        \
+        long long want = (expected);                                                                  \
+        if (got != want) {                                                                            \
+            printf("\nAssertion failed at %s:%d: %s (got %lld, expected %lld)\n", __FILE__, __LINE__, \
+                   #val " == " #expected, got, want);                                                 \
+            return 0;                                                                                 \
+        }                                                                                             \
+    } while (0)
+
+#define CHUNK (1u << 20)
+#define BOUNDARY 2147483648LL /* 2^31 */
+
+typedef struct large_doc {
+    char* p;
+    long long len;
+} large_doc;
+
+static int write_chunk(int fd, long long off, const char* text, char fill, int at_end) {
+    char* buf = (char*)malloc(CHUNK);
+    size_t n = strlen(text);
+    int ok;
+
+    if (!buf) return 0;
+    memset(buf, fill, CHUNK);
+    memcpy(at_end ? buf + CHUNK - n : buf, text, n);
+    ok = pwrite(fd, buf, CHUNK, (off_t)off) == (ssize_t)CHUNK;
+    free(buf);
+    return ok;
+}
+
+/* head + fill bytes + tail, exactly len bytes (a multiple of CHUNK) */
+static int large_doc_map(large_doc* d, const char* head, char fill, const char* tail, long long len) {
+    FILE* sparse = tmpfile();
+    FILE* filler = tmpfile();
+    long long off;
+    int ok = 0;
+
+    d->p = NULL;
+    d->len = len;
+    if (!sparse || !filler) goto out;
+    if (ftruncate(fileno(sparse), (off_t)len) != 0) goto out;
+    if (!write_chunk(fileno(sparse), 0, head, fill, 0)) goto out;
+    if (!write_chunk(fileno(sparse), len - CHUNK, tail, fill, 1)) goto out;
+    if (!write_chunk(fileno(filler), 0, "", fill, 0)) goto out;
+
+    d->p = (char*)mmap(NULL, (size_t)len, PROT_READ, MAP_SHARED, fileno(sparse), 0);
+    if (d->p == MAP_FAILED) {
+        d->p = NULL;
+        goto out;
+    }
+    for (off = CHUNK; off < len - CHUNK; off += CHUNK) {
+        if (mmap(d->p + off, CHUNK, PROT_READ, MAP_SHARED | MAP_FIXED, fileno(filler), 0) == MAP_FAILED) goto out;
+    }
+    ok = 1;
+
+out:
+    /* the mappings keep the files alive */
+    if (sparse) fclose(sparse);
+    if (filler) fclose(filler);
+    if (!ok && d->p) {
+        munmap(d->p, (size_t)len);
+        d->p = NULL;
+    }
+    return ok;
+}
+
+static void large_doc_unmap(large_doc* d) {
+    if (d->p) munmap(d->p, (size_t)d->len);
+    d->p = NULL;
+}
+
+int test_large_offsets(void) {
+    large_doc d;
+    jstok_parser p;
+    jstoktok_t toks[16];
+    jstok_off_t n, obj, v;
+    long long len = BOUNDARY + 2 * (long long)CHUNK;
+
+    ASSERT(large_doc_map(&d, "[", ' ', "1,\"x\",{\"k\":[true,-2.5e3]}]", len));
+
+    jstok_init(&p);
+    n = jstok_parse(&p, d.p, d.len, toks, 16);
+    ASSERT_EQ(n, 8);
+    ASSERT(toks[0].type == JSTOK_ARRAY);
+    ASSERT_EQ(toks[0].start, 0);
+    ASSERT_EQ(toks[0].end, len);
+    ASSERT_EQ(toks[0].size, 3);
+
+    ASSERT(toks[1].type == JSTOK_PRIMITIVE);
+    ASSERT(toks[1].start > BOUNDARY);
+    ASSERT_EQ(toks[1].start, len - 26);
+    ASSERT_EQ(toks[1].end, len - 25);
+    ASSERT_EQ(toks[2].start, len - 23);
+    ASSERT(jstok_eq(d.p, &toks[2], "x"));
+
+    obj = jstok_array_at(toks, n, 0, 2);
+    ASSERT_EQ(obj, 3);
+    v = jstok_object_get(d.p, toks, n, obj, "k");
+    ASSERT_EQ(v, 5);
+    v = jstok_path(d.p, toks, n, 0, 2, "k", 1, NULL);
+    ASSERT_EQ(v, 7);
+    ASSERT(jstok_eq(d.p, &toks[v], "-2.5e3"));
+    ASSERT_EQ(jstok_span(d.p, &toks[v]).n, 6);
+    ASSERT_EQ(jstok_skip(toks, n, 0), 8);
+
+    /* Count-only agrees */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, d.p, d.len, NULL, 0), 8);
+
+    /* Errors past the boundary report their real position */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, d.p, d.len - 1, toks, 16), JSTOK_ERROR_PART);
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, d.p, d.len, toks, 2), JSTOK_ERROR_NOMEM);
+    ASSERT_EQ(p.error_pos, len - 22); /* closing quote of "x" */
+
+    large_doc_unmap(&d);
+    return 1;
+}
+
+int test_large_string(void) {
+    large_doc d;
+    jstok_parser p;
+    jstoktok_t toks[4];
+    long long len = BOUNDARY + 2 * (long long)CHUNK;
+    long long cut;
+    jstok_off_t n;
+
+    ASSERT(large_doc_map(&d, "[\"", 'a', "\",7]", len));
+
+    jstok_init(&p);
+    n = jstok_parse(&p, d.p, d.len, toks, 4);
+    ASSERT_EQ(n, 3);
+    ASSERT(toks[1].type == JSTOK_STRING);
+    ASSERT_EQ(toks[1].start, 2);
+    ASSERT_EQ(toks[1].end, len - 4);
+    ASSERT_EQ(jstok_span(d.p, &toks[1]).n, len - 6);
+    ASSERT_EQ(toks[2].start, len - 2);
+
+    /* Streamed in chunks that straddle 2^31, the string resumes each time */
+    jstok_init(&p);
+    for (cut = BOUNDARY - 3 * (long long)CHUNK; cut < len; cut += 3 * (long long)CHUNK / 2) {
+        n = jstok_parse_ex(&p, d.p, cut, toks, 4, 0);
+        ASSERT_EQ(n, JSTOK_ERROR_PART);
+        ASSERT_EQ(p.pos, 1);
+    }
+    n = jstok_parse_ex(&p, d.p, d.len, toks, 4, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(n, 3);
+    ASSERT_EQ(toks[1].end, len - 4);
+
+    large_doc_unmap(&d);
+    return 1;
+}
+
+int main(void) {
+    if (sizeof(void*) < 8) {
+        printf("skipped: needs a 64-bit address space\n");
+        return 0;
+    }
+
+    printf("Starting jstok large document tests...\n");
+
+    TEST(large_offsets);
+    TEST(large_string);
+
+    printf("\nTests run: %d, Failed: %d\n", tests_run, tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
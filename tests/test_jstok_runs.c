@@ -0,0 +1,282 @@
+// test_jstok_runs.c: JSTOK_PRIMITIVE_RUNS, consecutive array primitives as one token
+#include <stdio.h>
+#include <string.h>
+
+#ifndef JSTOK_PRIMITIVE_RUNS
+#define JSTOK_PRIMITIVE_RUNS
+#endif
+
+#include "jstok.h"
+
+/* Minimal test framework */
+int tests_run = 0;
+int tests_failed = 0;
+
+#define TEST(name)                       \
+    do {                                 \
+        printf("Running %s... ", #name); \
+        if (test_##name()) {             \
+            printf("PASS\n");            \
+        } else {                         \
+            printf("FAIL\n");            \
+            tests_failed++;              \
+        }                                \
+        tests_run++;                     \
+    } while (0)
+
+#define ASSERT(cond)                                                                \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            printf("\nAssertion failed at %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            return 0;                                                               \
+        }                                                                           \
+    } while (0)
+
+#define ASSERT_EQ(val, expected)                                                                  \
+    do {                                                                                          \
+        int v = (val);                                                                            \
+        int e = (expected);                                                                       \
+        if (v != e) {                                                                             \
+            printf("\nAssertion failed at %s:%d: %s (got %d, expected %d)\n", __FILE__, __LINE__, \
+                   #val " == " #expected, v, e);                                                  \
+            return 0;                                                                             \
+        }                                                                                         \
+    } while (0)
+
+static const char doc[] =
+    "{\"v\": [1, 2.5, -3e2 , true,null], \"m\": [1, \"x\", 2, 3, [4, 5], 6], \"one\": [7], \"n\": 8, \"e\": []}";
+
+/* every field of two token arrays */
+static int same_tokens(const jstoktok_t* a, const jstoktok_t* b, int n) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (a[i].type != b[i].type || a[i].start != b[i].start || a[i].end != b[i].end || a[i].size != b[i].size)
+            return 0;
+#ifdef JSTOK_PARENT_LINKS
+        if (a[i].parent != b[i].parent) return 0;
+#endif
+#ifdef JSTOK_SKIP_LINKS
+        if (a[i].next != b[i].next) return 0;
+#endif
+    }
+    return 1;
+}
+
+int test_runs_tokens(void) {
+    jstok_parser p;
+    jstoktok_t t[32];
+    int n;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, (int)strlen(doc), t, 32);
+    ASSERT_EQ(n, 19); /* 25 without runs */
+
+    ASSERT(t[2].type == JSTOK_ARRAY);
+    ASSERT_EQ(t[2].size, 5); /* still elements */
+    ASSERT(t[3].type == JSTOK_PRIMITIVE_RUN);
+    ASSERT_EQ(t[3].size, 5);
+    ASSERT(jstok_eq(doc, &t[3], "1, 2.5, -3e2 , true,null"));
+
+    /* a string, a container or the array end breaks a run */
+    ASSERT_EQ(t[5].size, 6);
+    ASSERT(t[6].type == JSTOK_PRIMITIVE && t[6].size == 0 && jstok_eq(doc, &t[6], "1"));
+    ASSERT(t[7].type == JSTOK_STRING);
+    ASSERT(t[8].type == JSTOK_PRIMITIVE_RUN && t[8].size == 2 && jstok_eq(doc, &t[8], "2, 3"));
+    ASSERT(t[9].type == JSTOK_ARRAY && t[9].size == 2);
+    ASSERT(t[10].type == JSTOK_PRIMITIVE_RUN && jstok_eq(doc, &t[10], "4, 5"));
+    ASSERT(t[11].type == JSTOK_PRIMITIVE && jstok_eq(doc, &t[11], "6"));
+
+    /* a lone element stays a primitive, object values never run */
+    ASSERT(t[14].type == JSTOK_PRIMITIVE && jstok_eq(doc, &t[14], "7"));
+    ASSERT(t[16].type == JSTOK_PRIMITIVE && jstok_eq(doc, &t[16], "8"));
+    ASSERT(t[18].type == JSTOK_ARRAY && t[18].size == 0);
+
+#ifdef JSTOK_PARENT_LINKS
+    ASSERT_EQ(t[3].parent, 2);
+    ASSERT_EQ(t[10].parent, 9);
+    ASSERT_EQ(t[11].parent, 5);
+#endif
+#ifdef JSTOK_SKIP_LINKS
+    ASSERT_EQ(t[3].next, 4);
+    ASSERT_EQ(t[5].next, 12);
+#endif
+
+    /* Count-only agrees */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, doc, (int)strlen(doc), NULL, 0), n);
+    ASSERT_EQ(jstok_estimate_tokens(doc, (int)strlen(doc)), 25); /* one per primitive, an upper bound */
+    return 1;
+}
+
+/* NOMEM at any point and byte-by-byte input give the same runs */
+int test_runs_retry(void) {
+    static const char top[] = "[10, 20, 30, [], 40, 50]";
+    jstok_parser p;
+    jstoktok_t want[32], t[32];
+    int len = (int)strlen(doc);
+    int cap, have, n, r;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, len, want, 32);
+    ASSERT_EQ(n, 19);
+
+    for (cap = 1; cap < n; cap++) {
+        jstok_init(&p);
+        ASSERT_EQ(jstok_parse(&p, doc, len, t, cap), JSTOK_ERROR_NOMEM);
+        ASSERT_EQ(jstok_parse(&p, doc, len, t, 32), n);
+        ASSERT(same_tokens(t, want, n));
+    }
+
+    jstok_init(&p);
+    r = JSTOK_ERROR_PART;
+    for (have = 1; have <= len && r == JSTOK_ERROR_PART; have++) {
+        r = jstok_parse_ex(&p, doc, have, t, 32, have == len ? JSTOK_PARSE_FINAL : 0);
+    }
+    ASSERT_EQ(r, n);
+    ASSERT(same_tokens(t, want, n));
+
+    /* a number cut at the chunk end joins the run once it is complete */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_ex(&p, top, 6, t, 32, 0), JSTOK_ERROR_PART);
+    ASSERT(t[1].type == JSTOK_PRIMITIVE);
+    ASSERT_EQ(jstok_parse_ex(&p, top, 8, t, 32, 0), JSTOK_ERROR_PART);
+    ASSERT(t[1].type == JSTOK_PRIMITIVE_RUN && t[1].size == 2 && jstok_eq(top, &t[1], "10, 20"));
+    ASSERT_EQ(jstok_parse(&p, top, (int)strlen(top), t, 32), 4);
+    ASSERT_EQ(t[0].size, 6);
+    ASSERT(t[1].size == 3 && t[2].type == JSTOK_ARRAY && t[3].size == 2);
+    return 1;
+}
+
+int test_runs_helpers(void) {
+    jstok_parser p;
+    jstoktok_t t[32], e;
+    jstok_off_t parent[32], idx[8], pos;
+    long long v, sum;
+    int n, i, k, b;
+
+    jstok_init(&p);
+    n = jstok_parse(&p, doc, (int)strlen(doc), t, 32);
+    ASSERT_EQ(n, 19);
+
+    ASSERT_EQ(jstok_skip(t, n, 0), n);
+    ASSERT_EQ(jstok_skip(t, n, 2), 4);
+    ASSERT_EQ(jstok_skip(t, n, 3), 4);
+    ASSERT_EQ(jstok_skip(t, n, 5), 12);
+    ASSERT_EQ(jstok_skip_fast(t, n, 5), 12);
+
+    ASSERT_EQ(jstok_build_parents(t, n, parent), 0);
+    ASSERT_EQ(parent[3], 2);
+    ASSERT_EQ(parent[8], 5);
+    ASSERT_EQ(parent[10], 9);
+    ASSERT_EQ(parent[11], 5);
+    ASSERT_EQ(parent[12], 0);
+
+    /* element indices still count primitives, elements inside a run give the run */
+    ASSERT_EQ(jstok_array_at(t, n, 2, 0), 3);
+    ASSERT_EQ(jstok_array_at(t, n, 2, 4), 3);
+    ASSERT_EQ(jstok_array_at(t, n, 2, 5), -1);
+    ASSERT_EQ(jstok_array_at(t, n, 5, 1), 7);
+    ASSERT_EQ(jstok_array_at(t, n, 5, 3), 8);
+    ASSERT_EQ(jstok_array_at(t, n, 5, 4), 9);
+    ASSERT_EQ(jstok_array_at(t, n, 5, 5), 11);
+    ASSERT_EQ(jstok_path(doc, t, n, 0, "m", 4, 1, NULL), 10);
+    ASSERT_EQ(jstok_object_get(doc, t, n, 0, "n"), 16);
+    ASSERT_EQ(jstok_array_index(t, n, 5, idx, 8), 6);
+    ASSERT(idx[0] == 6 && idx[2] == 8 && idx[3] == 8 && idx[4] == 9 && idx[5] == 11);
+
+    /* single elements, lazily */
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 2, 1, &e), 3);
+    ASSERT(e.type == JSTOK_PRIMITIVE && jstok_eq(doc, &e, "2.5"));
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 2, 2, &e), 3);
+    ASSERT(jstok_eq(doc, &e, "-3e2"));
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 2, 3, &e), 3);
+    ASSERT(jstok_atob(doc, &e, &b) == 0 && b == 1);
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 2, 4, &e), 3);
+    ASSERT(jstok_eq(doc, &e, "null"));
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 5, 3, &e), 8);
+    ASSERT(jstok_atoi64(doc, &e, &v) == 0 && v == 3);
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 5, 1, &e), 7);
+    ASSERT(e.type == JSTOK_STRING && jstok_eq(doc, &e, "x"));
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 5, 6, &e), -1);
+    ASSERT_EQ(jstok_array_elem(doc, t, n, 18, 0, &e), -1);
+
+    /* iteration, a lone primitive is a run of one */
+    pos = t[8].start;
+    for (k = 0, sum = 0; jstok_run_next(doc, &t[8], &pos, &e); k++) {
+        ASSERT(jstok_atoi64(doc, &e, &v) == 0);
+        sum += v;
+    }
+    ASSERT(k == 2 && sum == 5);
+    pos = t[3].start;
+    for (k = 0; jstok_run_next(doc, &t[3], &pos, &e); k++) {
+        jstoktok_t at;
+
+        ASSERT_EQ(jstok_array_elem(doc, t, n, 2, k, &at), 3);
+        ASSERT(at.start == e.start && at.end == e.end);
+    }
+    ASSERT_EQ(k, 5);
+    pos = t[14].start;
+    ASSERT(jstok_run_next(doc, &t[14], &pos, &e) && jstok_eq(doc, &e, "7"));
+    ASSERT(!jstok_run_next(doc, &t[14], &pos, &e));
+    pos = 0;
+    ASSERT(!jstok_run_next(doc, &t[7], &pos, &e)); /* strings are no runs */
+
+    /* skip and parents over a partial parse */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, doc, 30, t, 32), JSTOK_ERROR_PART);
+    n = p.toknext;
+    for (i = 0; i < n; i++) ASSERT(jstok_skip(t, n, i) <= n);
+    ASSERT_EQ(jstok_build_parents(t, n, parent), 0);
+    ASSERT_EQ(parent[3], 2);
+
+    /* an open array owns what follows its run, however many elements the run holds */
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse_ex(&p, "[83, null, true, \"s4\"", 21, t, 32, 0), JSTOK_ERROR_PART);
+    ASSERT_EQ(p.toknext, 3);
+    ASSERT_EQ(jstok_build_parents(t, 3, parent), 0);
+    ASSERT_EQ(parent[1], 0);
+    ASSERT_EQ(parent[2], 0);
+    return 1;
+}
+
+int test_runs_soa(void) {
+    unsigned char type[32];
+    jstok_off_t start[32], end[32], size[32], parent[32];
+    jstok_soa_t soa = {type, start, end, size, parent};
+    jstok_parser p;
+    jstoktok_t t[32];
+    int n, i;
+
+    jstok_init(&p);
+    n = jstok_parse_soa(&p, doc, (int)strlen(doc), &soa, 32, JSTOK_PARSE_FINAL);
+    ASSERT_EQ(n, 19);
+    jstok_init(&p);
+    ASSERT_EQ(jstok_parse(&p, doc, (int)strlen(doc), t, 32), n);
+    for (i = 0; i < n; i++) {
+        ASSERT(type[i] == (unsigned char)t[i].type);
+        ASSERT(start[i] == t[i].start && end[i] == t[i].end && size[i] == t[i].size);
+    }
+    ASSERT_EQ(parent[10], 9);
+
+    for (i = 0; i < 6; i++) ASSERT_EQ(jstok_soa_array_at(&soa, n, 5, i), jstok_array_at(t, n, 5, i));
+    ASSERT_EQ(jstok_soa_array_at(&soa, n, 2, 4), 3);
+    ASSERT_EQ(jstok_soa_array_at(&soa, n, 2, 5), -1);
+    ASSERT_EQ(jstok_soa_skip(&soa, n, 3), 4);
+    ASSERT_EQ(jstok_soa_skip(&soa, n, 5), 12);
+    ASSERT_EQ(jstok_soa_object_get(doc, &soa, n, 0, "one"), 13);
+    return 1;
+}
+
+int main(void) {
+    printf("Starting jstok primitive run tests...\n");
+
+    TEST(runs_tokens);
+    TEST(runs_retry);
+    TEST(runs_helpers);
+    TEST(runs_soa);
+
+    printf("\nTests run: %d, Failed: %d\n", tests_run, tests_failed);
+
+    return tests_failed > 0 ? 1 : 0;
+}
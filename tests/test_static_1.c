@@ -14,6 +14,18 @@ int main(void) {
     (void)jstok_unescape;
     (void)jstok_path;
     (void)jstok_sse_next;
+    (void)jstok_parse_soa;
+    (void)jstok_parse_grow;
+    (void)jstok_estimate_tokens;
+    (void)jstok_init_frames;
+    (void)jstok_build_parents;
+    (void)jstok_skip_fast;
+    (void)jstok_array_index;
+    (void)jstok_array_index_at;
+    (void)jstok_object_index;
+    (void)jstok_object_index_get;
+    (void)jstok_soa_array_at;
+    (void)jstok_soa_object_get;
 
     func2();
     return 0;